@@ -0,0 +1,243 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include <cmath>
+
+#include "../math/GenoSimd.h"
+
+#include "GenoAnimationSampler.h"
+
+GenoAnimationSampler::GenoAnimationSampler() {}
+
+uint32 GenoAnimationSampler::addTrack(const GenoAnimationTrackCreateInfo & info) {
+	// Track types are defined as their channel counts
+	uint32 numChannels  = info.type;
+	uint32 numKeys      = info.numKeys;
+	uint32 outputStride = info.outputStride == 0 ? 1 : info.outputStride;
+	bool   hermite      = info.interpolation == GENO_ANIMATION_INTERPOLATION_HERMITE;
+
+	// Sampling walks the keys assuming there is at least one and that they are in order
+	if (numKeys == 0 || numChannels == 0 || numChannels > GENO_ANIMATION_TRACK_QUATERNION || !info.times || !info.values || (hermite && !info.tangents))
+		return GENO_ANIMATION_INVALID_TRACK;
+	if (info.interpolation > GENO_ANIMATION_INTERPOLATION_HERMITE || info.wrap > GENO_ANIMATION_WRAP_LOOP)
+		return GENO_ANIMATION_INVALID_TRACK;
+	for (uint32 i = 1; i < numKeys; ++i)
+		if (!(info.times[i] >= info.times[i - 1]))
+			return GENO_ANIMATION_INVALID_TRACK;
+
+	// Consecutive quaternion keys are flipped into the same hemisphere so
+	// interpolating them component-wise always takes the shortest path
+	float * signs = new float[numKeys];
+	signs[0] = 1;
+	for (uint32 i = 1; i < numKeys; ++i) {
+		signs[i] = signs[i - 1];
+		if (info.type == GENO_ANIMATION_TRACK_QUATERNION) {
+			float dot = 0;
+			for (uint32 j = 0; j < numChannels; ++j)
+				dot += info.values[(i - 1) * numChannels + j] * info.values[i * numChannels + j];
+			if (dot < 0)
+				signs[i] = -signs[i];
+		}
+	}
+
+	// Single key tracks are stored as two identical keys so every sample has a pair to interpolate between
+	uint32 storedKeys = numKeys == 1 ? 2 : numKeys;
+
+	uint32 track = trackKeys.getLength();
+	trackTimes.add(times.getLength());
+	trackKeys.add(storedKeys);
+	trackCursors.add(0);
+	trackInterpolations.add(info.interpolation);
+	trackWraps.add(info.wrap);
+	for (uint32 i = 0; i < 4; ++i)
+		trackWeights.add(0);
+
+	for (uint32 i = 0; i < numKeys; ++i)
+		times.add(info.times[i]);
+	if (numKeys == 1)
+		times.add(info.times[0] + 1);
+
+	for (uint32 i = 0; i < numChannels; ++i) {
+		channelTracks.add(track);
+		channelValues.add(values.getLength());
+		channelOutputs.add(info.output + i * outputStride);
+		for (uint32 j = 0; j < storedKeys; ++j) {
+			uint32 key = j < numKeys ? j : numKeys - 1;
+			values.add(info.values[key * numChannels + i] * signs[key]);
+		}
+		if (hermite) {
+			channelTangents.add(tangents.getLength());
+			for (uint32 j = 0; j < storedKeys; ++j) {
+				uint32 key = j < numKeys ? j : numKeys - 1;
+				tangents.add(info.tangents[key * numChannels + i] * signs[key]);
+			}
+		}
+		else
+			channelTangents.add(channelValues[channelValues.getLength() - 1]);
+	}
+
+	if (info.type == GENO_ANIMATION_TRACK_QUATERNION) {
+		quaternionOutputs.add(info.output);
+		quaternionStrides.add(outputStride);
+	}
+
+	delete [] signs;
+
+	return track;
+}
+
+void GenoAnimationSampler::updateCursors(float time) {
+	uint32 numTracks = trackKeys.getLength();
+	for (uint32 i = 0; i < numTracks; ++i) {
+		const float * keyTimes = &times[trackTimes[i]];
+		uint32 numKeys = trackKeys[i];
+		float first = keyTimes[0];
+		float last  = keyTimes[numKeys - 1];
+
+		float local = time;
+		if (trackWraps[i] == GENO_ANIMATION_WRAP_LOOP && last > first) {
+			local = first + std::fmod(time - first, last - first);
+			if (local < first)
+				local += last - first;
+		}
+		if (local < first)
+			local = first;
+		else if (local > last)
+			local = last;
+
+		// Walk forward from the cached key, only restarting when time moved backwards
+		uint32 key = trackCursors[i];
+		if (keyTimes[key] > local)
+			key = 0;
+		while (key + 2 < numKeys && keyTimes[key + 1] <= local)
+			++key;
+		trackCursors[i] = key;
+
+		float duration = keyTimes[key + 1] - keyTimes[key];
+		float s = duration > 0 ? (local - keyTimes[key]) / duration : 0;
+		float * weights = &trackWeights[i * 4];
+		if (trackInterpolations[i] == GENO_ANIMATION_INTERPOLATION_HERMITE) {
+			float s2 = s  * s;
+			float s3 = s2 * s;
+			weights[0] = 2 * s3 - 3 * s2 + 1;
+			weights[1] = 3 * s2 - 2 * s3;
+			weights[2] = (s3 - 2 * s2 + s) * duration;
+			weights[3] = (s3 - s2) * duration;
+		}
+		else {
+			weights[0] = 1 - s;
+			weights[1] = s;
+			weights[2] = 0;
+			weights[3] = 0;
+		}
+	}
+}
+
+void GenoAnimationSampler::interpolate(float * output) {
+	uint32 numChannels = channelTracks.getLength();
+	if (numChannels == 0)
+		return;
+	const float * valueData   = &values[0];
+	const float * tangentData = tangents.getLength() > 0 ? &tangents[0] : valueData;
+	const float * weightData  = &trackWeights[0];
+
+	uint32 i = 0;
+	#ifdef GENO_SIMD_SSE
+	for (; i + 4 <= numChannels; i += 4) {
+		float starts[4], ends[4], startTangents[4], endTangents[4];
+		float weights[4][4];
+		for (uint32 j = 0; j < 4; ++j) {
+			uint32 track = channelTracks[i + j];
+			uint32 key   = trackCursors[track];
+			const float * channelTangentData = trackInterpolations[track] == GENO_ANIMATION_INTERPOLATION_HERMITE ? tangentData : valueData;
+			starts[j]        = valueData[channelValues[i + j] + key    ];
+			ends[j]          = valueData[channelValues[i + j] + key + 1];
+			startTangents[j] = channelTangentData[channelTangents[i + j] + key    ];
+			endTangents[j]   = channelTangentData[channelTangents[i + j] + key + 1];
+			for (uint32 k = 0; k < 4; ++k)
+				weights[k][j] = weightData[track * 4 + k];
+		}
+		__m128 result = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(weights[0]), _mm_loadu_ps(starts)),
+			           _mm_mul_ps(_mm_loadu_ps(weights[1]), _mm_loadu_ps(ends))),
+			_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(weights[2]), _mm_loadu_ps(startTangents)),
+			           _mm_mul_ps(_mm_loadu_ps(weights[3]), _mm_loadu_ps(endTangents)))
+		);
+		float results[4];
+		_mm_storeu_ps(results, result);
+		for (uint32 j = 0; j < 4; ++j)
+			output[channelOutputs[i + j]] = results[j];
+	}
+	#endif // GENO_SIMD_SSE
+	for (; i < numChannels; ++i) {
+		uint32 track = channelTracks[i];
+		uint32 key   = trackCursors[track];
+		const float * weights = weightData + track * 4;
+		const float * channelTangentData = trackInterpolations[track] == GENO_ANIMATION_INTERPOLATION_HERMITE ? tangentData : valueData;
+		output[channelOutputs[i]] = weights[0] * valueData[channelValues[i] + key    ]
+		                          + weights[1] * valueData[channelValues[i] + key + 1]
+		                          + weights[2] * channelTangentData[channelTangents[i] + key    ]
+		                          + weights[3] * channelTangentData[channelTangents[i] + key + 1];
+	}
+}
+
+void GenoAnimationSampler::normalizeQuaternions(float * output) {
+	uint32 numQuaternions = quaternionOutputs.getLength();
+	for (uint32 i = 0; i < numQuaternions; ++i) {
+		uint32 stride = quaternionStrides[i];
+		float * x = output + quaternionOutputs[i];
+		float length = std::sqrt(x[0] * x[0] + x[stride] * x[stride] + x[stride * 2] * x[stride * 2] + x[stride * 3] * x[stride * 3]);
+		if (length > 0) {
+			float invLength = 1 / length;
+			x[0         ] *= invLength;
+			x[stride    ] *= invLength;
+			x[stride * 2] *= invLength;
+			x[stride * 3] *= invLength;
+		}
+	}
+}
+
+void GenoAnimationSampler::sample(float time, float * output) {
+	updateCursors(time);
+	interpolate(output);
+	normalizeQuaternions(output);
+}
+
+void GenoAnimationSampler::reset() {
+	uint32 numTracks = trackCursors.getLength();
+	for (uint32 i = 0; i < numTracks; ++i)
+		trackCursors[i] = 0;
+}
+
+uint32 GenoAnimationSampler::getTrackCount() const {
+	return trackKeys.getLength();
+}
+
+uint32 GenoAnimationSampler::getChannelCount() const {
+	return channelTracks.getLength();
+}
+
+GenoAnimationSampler::~GenoAnimationSampler() {}
\ No newline at end of file
@@ -0,0 +1,131 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_ANIMATION_SAMPLER
+#define GNARLY_GENOME_ANIMATION_SAMPLER
+
+#include "../GenoInts.h"
+#include "../template/GenoArrayList.h"
+
+#define GENO_ANIMATION_TRACK_FLOAT      0x01
+#define GENO_ANIMATION_TRACK_VECTOR2    0x02
+#define GENO_ANIMATION_TRACK_VECTOR3    0x03
+#define GENO_ANIMATION_TRACK_QUATERNION 0x04
+
+#define GENO_ANIMATION_INTERPOLATION_LINEAR  0x00
+#define GENO_ANIMATION_INTERPOLATION_HERMITE 0x01
+
+#define GENO_ANIMATION_WRAP_CLAMP 0x00
+#define GENO_ANIMATION_WRAP_LOOP  0x01
+
+/**
+ * Returned by GenoAnimationSampler::addTrack for a track that cannot be sampled
+**/
+#define GENO_ANIMATION_INVALID_TRACK 0xFFFFFFFF
+
+struct GenoAnimationTrackCreateInfo {
+	uint32        type;
+	uint32        interpolation;
+	uint32        wrap;
+	uint32        numKeys;
+	const float * times;
+	const float * values;
+	const float * tangents;
+	uint32        output;
+	uint32        outputStride;
+};
+
+/**
+ * Samples keyframe tracks in bulk
+ *
+ * Keys are stored channel by channel so every channel of every track is evaluated by the same
+ * interpolation kernel. Each track caches the key it last sampled, so sampling with a steadily
+ * increasing time walks forward from there instead of searching the keys.
+**/
+class GenoAnimationSampler {
+	private:
+		GenoArrayList<float> times;
+		GenoArrayList<float> values;
+		GenoArrayList<float> tangents;
+
+		GenoArrayList<uint32> trackTimes;
+		GenoArrayList<uint32> trackKeys;
+		GenoArrayList<uint32> trackCursors;
+		GenoArrayList<uint8 > trackInterpolations;
+		GenoArrayList<uint8 > trackWraps;
+		GenoArrayList<float > trackWeights;
+
+		GenoArrayList<uint32> channelTracks;
+		GenoArrayList<uint32> channelValues;
+		GenoArrayList<uint32> channelTangents;
+		GenoArrayList<uint32> channelOutputs;
+
+		GenoArrayList<uint32> quaternionOutputs;
+		GenoArrayList<uint32> quaternionStrides;
+
+		void updateCursors(float time);
+		void interpolate(float * output);
+		void normalizeQuaternions(float * output);
+	public:
+		GenoAnimationSampler();
+
+		/**
+		 * Adds a track to the sampler
+		 *
+		 * Values and tangents are given key by key with the components of each key adjacent. Quaternions
+		 * are given as x, y, z, w. Tangents are only read by hermite tracks. Key times must not decrease.
+		 *
+		 * @param info - The track info struct
+		 *
+		 * @return - The index of the track, GENO_ANIMATION_INVALID_TRACK if the track has no keys, its
+		 *           key times decrease, its type, interpolation or wrap is unknown or the values or
+		 *           tangents it needs are missing
+		**/
+		uint32 addTrack(const GenoAnimationTrackCreateInfo & info);
+
+		/**
+		 * Samples every track and writes the results into the output array
+		 *
+		 * Each track writes its channels starting at its output index, outputStride floats apart
+		 *
+		 * @param time - The time to sample at
+		 * @param output - The output array
+		**/
+		void sample(float time, float * output);
+
+		/**
+		 * Resets every cached cursor to the first key
+		**/
+		void reset();
+
+		uint32 getTrackCount() const;
+		uint32 getChannelCount() const;
+
+		~GenoAnimationSampler();
+};
+
+#define GNARLY_GENOME_ANIMATION_SAMPLER_FORWARD
+#endif // GNARLY_GENOME_ANIMATION_SAMPLER
\ No newline at end of file
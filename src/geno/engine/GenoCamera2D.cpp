@@ -29,6 +29,11 @@
 GenoCamera2D::GenoCamera2D(float left, float right, float bottom, float top, float near, float far) :
 	width(right - left),
 	height(bottom - top),
+	scaleZ(2 / (far - near)),
+	translateZ((near + far) / (near - far)),
+	affineProjection(GenoAffine2::makeOrthographic(left, right, bottom, top)),
+	affineView(GenoAffine2::makeIdentity()),
+	affineProjectionView(affineProjection),
 	projection(GenoMatrix4f::makeOrthographic(left, right, bottom, top, near, far)),
 	view(GenoMatrix4f::makeIdentity()),
 	projectionView(projection),
@@ -36,11 +41,20 @@ GenoCamera2D::GenoCamera2D(float left, float right, float bottom, float top, flo
 	rotation(0) {}
 
 void GenoCamera2D::update() {
-	view.setTranslateXY(-position).rotateZ(-rotation);
-	projectionView = projection * view;
+	// translate(-position) * rotate(-rotation), composed directly
+	float sinR = std::sin(-rotation);
+	float cosR = std::cos(-rotation);
+	affineView = { cosR, sinR, -sinR, cosR, -position.v[0], -position.v[1] };
+	GenoAffine2::compose(affineProjection, affineView, affineProjectionView);
+
+	affineView.toMatrix4(view.m);
+	affineProjectionView.toMatrix4(projectionView.m, scaleZ, translateZ);
 }
 
 void GenoCamera2D::setProjection(float left, float right, float bottom, float top, float near, float far) {
+	scaleZ     = 2 / (far - near);
+	translateZ = (near + far) / (near - far);
+	affineProjection = GenoAffine2::makeOrthographic(left, right, bottom, top);
 	projection.setOrthographic(left, right, bottom, top, near, far);
 }
 
@@ -56,6 +70,18 @@ GenoMatrix4f GenoCamera2D::getVPMatrix() {
 	return projectionView;
 }
 
+const GenoAffine2 & GenoCamera2D::getAffineProjection() const {
+	return affineProjection;
+}
+
+const GenoAffine2 & GenoCamera2D::getAffineView() const {
+	return affineView;
+}
+
+const GenoAffine2 & GenoCamera2D::getAffineVP() const {
+	return affineProjectionView;
+}
+
 float GenoCamera2D::getWidth() {
 	return width;
 }
@@ -29,12 +29,20 @@
 
 #include "../math/linear/GenoVector2.h"
 #include "../math/linear/GenoMatrix4.h"
+#include "../math/linear/GenoAffine2.h"
 
 class GenoCamera2D {
 	private:
 		float width;
 		float height;
 
+		float scaleZ;
+		float translateZ;
+
+		GenoAffine2 affineProjection;
+		GenoAffine2 affineView;
+		GenoAffine2 affineProjectionView;
+
 		GenoMatrix4f projection;
 		GenoMatrix4f view;
 		GenoMatrix4f projectionView;
@@ -48,6 +56,9 @@ class GenoCamera2D {
 		GenoMatrix4f getProjection();
 		GenoMatrix4f getView();
 		GenoMatrix4f getVPMatrix();
+		const GenoAffine2 & getAffineProjection() const;
+		const GenoAffine2 & getAffineView() const;
+		const GenoAffine2 & getAffineVP() const;
 		float getWidth();
 		float getHeight();
 		GenoVector2f getDimensions();
@@ -30,6 +30,7 @@
 #include "GenoInput.h"
 #include "GenoMonitor.h"
 #include "../audio/GenoAudioDevice.h"
+#include "../thread/GenoDispatchQueue.h"
 
 #include "GenoEngine.h"
 
@@ -40,10 +41,13 @@ namespace {
 GenoLoopCallback GenoEngine::callback = 0;
 GenoLoop * GenoEngine::loop = 0;
 GenoEngine::GenoEventPollFunc GenoEngine::getEvents = 0;
+GenoDispatchQueue * GenoEngine::mainQueue = 0;
+double GenoEngine::dispatchBudget = GENO_ENGINE_DEFAULT_DISPATCH_BUDGET;
 
 void GenoEngine::defaultLoop() {
 	GenoInput::update();
 	GenoEngine::pollEvents();
+	mainQueue->drain(dispatchBudget);
 	callback();
 }
 
@@ -56,6 +60,7 @@ bool GenoEngine::init() {
 	}
 
 	getEvents = glfwPollEvents;
+	mainQueue = new GenoDispatchQueue();
 
 	GenoMonitors::init();
 	GenoAudioDevices::init();
@@ -98,6 +103,9 @@ void GenoEngine::destroy() {
 	GenoAudioDevices::cleanup();
 	GenoMonitors::cleanup();
 
+	delete mainQueue;
+	mainQueue = 0;
+
 	glfwTerminate();
 }
 
@@ -117,6 +125,14 @@ GenoLoop * GenoEngine::getLoop() {
 	return loop;
 }
 
+GenoDispatchQueue * GenoEngine::getMainQueue() {
+	return mainQueue;
+}
+
+void GenoEngine::setDispatchBudget(double budget) {
+	dispatchBudget = budget;
+}
+
 GenoEngine::GenoEngine() {}
 GenoEngine::~GenoEngine() {}
 
@@ -31,6 +31,13 @@ class GenoLoop;
 
 #endif // GNARLY_GENOME_LOOP_FORWARD
 
+#ifndef GNARLY_GENOME_DISPATCH_QUEUE_FORWARD
+#define GNARLY_GENOME_DISPATCH_QUEUE_FORWARD
+
+class GenoDispatchQueue;
+
+#endif // GNARLY_GENOME_DISPATCH_QUEUE_FORWARD
+
 #ifndef GNARLY_GENOME_ENGINE
 #define GNARLY_GENOME_ENGINE
 
@@ -41,6 +48,11 @@ class GenoLoop;
 #define GENO_ENGINE_EVENTS_WAIT false
 #define GENO_ENGINE_EVENTS_POLL true
 
+/**
+ * The default time in milliseconds the default loop spends on the main thread queue each frame
+**/
+#define GENO_ENGINE_DEFAULT_DISPATCH_BUDGET 2
+
 /**
  * The engine
 **/
@@ -51,6 +63,8 @@ class GenoEngine final {
 		static GenoLoopCallback callback;
 		static GenoLoop * loop;
 		static GenoEventPollFunc getEvents;
+		static GenoDispatchQueue * mainQueue;
+		static double dispatchBudget;
 
 		static void defaultLoop();
 
@@ -73,6 +87,9 @@ class GenoEngine final {
 		/**
 		 * Sets the parameters for the loop. Can either override the default loop or run in conjunction with it
 		 *
+		 * The default loop updates input, polls events and drains the main thread queue before calling back.
+		 * An overriding loop has to drain the main thread queue itself.
+		 *
 		 * @param info - The loop info struct
 		 * @param overrideDefault - Whether or not to override the default loop
 		**/
@@ -116,6 +133,22 @@ class GenoEngine final {
 		 * Returns the game loop
 		**/
 		static GenoLoop * getLoop();
+
+		/**
+		 * Returns the queue of jobs to run on the main thread, which owns the GL context
+		 *
+		 * Pool jobs post GL work such as uploads and deletions here. Valid between init and destroy.
+		**/
+		static GenoDispatchQueue * getMainQueue();
+
+		/**
+		 * Sets the time the default loop spends on the main thread queue each frame
+		 *
+		 * Jobs that do not fit are carried over to the next frame.
+		 *
+		 * @param budget - The budget in milliseconds
+		**/
+		static void setDispatchBudget(double budget);
 };
 
 #define GNARLY_GENOME_ENGINE_FORWARD
@@ -175,4 +175,10 @@ void GenoMvpShader::setMvp(const GenoMatrix4f & mvp) {
 
 void GenoMvpShader::setMvp(const float * mvp) {
 	glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, mvp);
+}
+
+void GenoMvpShader::setMvp(const GenoAffine2 & mvp) {
+	float matrix[4 * 4];
+	mvp.toMatrix4(matrix);
+	glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, matrix);
 }
\ No newline at end of file
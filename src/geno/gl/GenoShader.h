@@ -30,6 +30,7 @@
 #include "../GenoInts.h"
 
 #include "../math/linear/GenoMatrix4.h"
+#include "../math/linear/GenoAffine2.h"
 
 #define GENO_SHADER_STRING_IS_SOURCE 0x00
 #define GENO_SHADER_STRING_IS_PATH   0x01
@@ -58,6 +59,7 @@ class GenoMvpShader : public GenoShader {
 	public:
 		void setMvp(const GenoMatrix4f & mvp);
 		void setMvp(const float * mvp);
+		void setMvp(const GenoAffine2 & mvp);
 
 };
 
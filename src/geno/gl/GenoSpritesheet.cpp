@@ -160,6 +160,21 @@ GenoMatrix4f GenoSpritesheet::getTransform(const GenoVector2i & coords) const {
 	                                     coords.v[1] * fractionalHeight + paddingY).scaleXY(scaleX, scaleY);
 }
 
+GenoAffine2 GenoSpritesheet::getAffineTransform(uint32 sprite) const {
+	return { scaleX, 0, 0, scaleY, (sprite % numSpritesX) * fractionalWidth  + paddingX,
+	                               (sprite / numSpritesX) * fractionalHeight + paddingY };
+}
+
+GenoAffine2 GenoSpritesheet::getAffineTransform(uint32 x, uint32 y) const {
+	return { scaleX, 0, 0, scaleY, x * fractionalWidth  + paddingX,
+	                               y * fractionalHeight + paddingY };
+}
+
+GenoAffine2 GenoSpritesheet::getAffineTransform(const GenoVector2i & coords) const {
+	return { scaleX, 0, 0, scaleY, coords.v[0] * fractionalWidth  + paddingX,
+	                               coords.v[1] * fractionalHeight + paddingY };
+}
+
 void GenoSpritesheet::bind(uint8 textureNum) const {
 	glActiveTexture(GL_TEXTURE0 + textureNum);
 	glBindTexture(GL_TEXTURE_2D, id);
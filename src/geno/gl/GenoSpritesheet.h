@@ -40,6 +40,7 @@ class GenoTexture;
 
 #include "../GenoInts.h"
 #include "../math/linear/GenoMatrix4.h"
+#include "../math/linear/GenoAffine2.h"
 #include "../math/linear/GenoVector2.h"
 #include "GenoTexture.h"
 
@@ -82,6 +83,10 @@ class GenoSpritesheet : public GenoTexture {
 		GenoMatrix4f getTransform(uint32 x, uint32 y) const;
 		GenoMatrix4f getTransform(const GenoVector2i & coords) const;
 
+		GenoAffine2 getAffineTransform(uint32 sprite) const;
+		GenoAffine2 getAffineTransform(uint32 x, uint32 y) const;
+		GenoAffine2 getAffineTransform(const GenoVector2i & coords) const;
+
 		virtual void bind(uint8 textureNum = 0) const;
 		virtual void unbind() const;
 
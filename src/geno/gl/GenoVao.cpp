@@ -40,7 +40,9 @@ template<> struct GenoVertexAttribType<uint32> { const static uint32 TYPE = GL_I
 template<> struct GenoVertexAttribType<float > { const static uint32 TYPE = GL_FLOAT;          };
 template<> struct GenoVertexAttribType<double> { const static uint32 TYPE = GL_DOUBLE;         };
 
-GenoVao::GenoVao(uint32 num, float verts[], uint32 count, uint32 indices[]) {
+GenoVao::GenoVao(uint32 num, float verts[], uint32 count, uint32 indices[], GenoThreadPool * pool) :
+	bounds(GenoBounds::computeAabb(num, verts, 3, pool)),
+	boundingSphere(GenoBounds::computeSphere(bounds, num, verts, 3, pool)) {
 	this->count = count;
 	glGenVertexArrays(1, &vao);
 	addAttrib(num, 3, verts);
@@ -60,6 +62,14 @@ void GenoVao::addAttrib(uint32 num, uint32 stride, T data[]) {
 	++attribs;
 }
 
+const GenoAabb & GenoVao::getBounds() const {
+	return bounds;
+}
+
+const GenoBoundingSphere & GenoVao::getBoundingSphere() const {
+	return boundingSphere;
+}
+
 void GenoVao::render() {
 	glBindVertexArray(vao);
 	glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
@@ -28,14 +28,19 @@
 #define GNARLY_GENOME_VAO
 
 #include "../GenoInts.h"
+#include "../math/GenoBounds.h"
 
 class GenoVao {
 	private:
 		uint32 vao, vbos[15], ibo, count;
 		uint8 attribs = 0;
+		GenoAabb bounds;
+		GenoBoundingSphere boundingSphere;
 	public:
-		GenoVao(uint32 num, float verts[], uint32 count, uint32 indices[]);
+		GenoVao(uint32 num, float verts[], uint32 count, uint32 indices[], GenoThreadPool * pool = 0);
 		template <typename T> void addAttrib(uint32 num, uint32 stride, T data[]);
+		const GenoAabb & getBounds() const;
+		const GenoBoundingSphere & getBoundingSphere() const;
 		void render();
 		~GenoVao();
 };
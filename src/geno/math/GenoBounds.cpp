@@ -0,0 +1,426 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include <cmath>
+
+#include "GenoSimd.h"
+#include "../thread/GenoThreadPool.h"
+
+#include "GenoBounds.h"
+
+#define GENO_BOUNDS_MAX_CHUNKS 64
+
+namespace {
+	struct GenoVertexStream {
+		const float * verts;
+		uint32 stride;
+		const float * xs;
+		const float * ys;
+		const float * zs;
+	};
+
+	struct GenoBoundsJob {
+		const GenoVertexStream * stream;
+		uint32 begin;
+		uint32 end;
+		float params[3];
+		float out[6];
+		double sums[3];
+	};
+
+	#ifdef GENO_SIMD_SSE
+	float horizontalMin(__m128 v) {
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	float horizontalMax(__m128 v) {
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	__m128 gather(const float * verts, uint32 stride) {
+		return _mm_set_ps(verts[stride * 3], verts[stride * 2], verts[stride], verts[0]);
+	}
+	#endif // GENO_SIMD_SSE
+
+	float x(const GenoVertexStream & stream, uint32 i) {
+		return stream.verts != 0 ? stream.verts[i * stream.stride    ] : stream.xs[i];
+	}
+
+	float y(const GenoVertexStream & stream, uint32 i) {
+		return stream.verts != 0 ? stream.verts[i * stream.stride + 1] : stream.ys[i];
+	}
+
+	float z(const GenoVertexStream & stream, uint32 i) {
+		return stream.verts != 0 ? stream.verts[i * stream.stride + 2] : stream.zs[i];
+	}
+
+	void aabbKernel(void * data) {
+		GenoBoundsJob & job = *((GenoBoundsJob *) data);
+		const GenoVertexStream & stream = *job.stream;
+		uint32 i = job.begin;
+		float mins[3] = { x(stream, i), y(stream, i), z(stream, i) };
+		float maxs[3] = { mins[0], mins[1], mins[2] };
+		#ifdef GENO_SIMD_SSE
+		// Loads four floats per vertex, the fourth lane is ignored. With a stride of 3 the final vertex
+		// of the range is left to the scalar loop so the load never runs past the end of the stream
+		uint32 vertEnd = stream.stride > 3 ? job.end : job.end - 1;
+		if (stream.verts != 0 && i < vertEnd) {
+			uint32 end = vertEnd;
+			__m128 min = _mm_loadu_ps(stream.verts + i * stream.stride);
+			__m128 max = min;
+			for (++i; i < end; ++i) {
+				__m128 vert = _mm_loadu_ps(stream.verts + i * stream.stride);
+				min = _mm_min_ps(min, vert);
+				max = _mm_max_ps(max, vert);
+			}
+			float minOut[4];
+			float maxOut[4];
+			_mm_storeu_ps(minOut, min);
+			_mm_storeu_ps(maxOut, max);
+			for (uint32 j = 0; j < 3; ++j) {
+				mins[j] = minOut[j];
+				maxs[j] = maxOut[j];
+			}
+		}
+		else if (stream.verts == 0) {
+			const float * components[] = { stream.xs, stream.ys, stream.zs };
+			uint32 end = job.begin + ((job.end - job.begin) & ~3u);
+			for (uint32 j = 0; j < 3; ++j) {
+				if (end > job.begin) {
+					__m128 min = _mm_loadu_ps(components[j] + job.begin);
+					__m128 max = min;
+					for (uint32 k = job.begin + 4; k < end; k += 4) {
+						__m128 values = _mm_loadu_ps(components[j] + k);
+						min = _mm_min_ps(min, values);
+						max = _mm_max_ps(max, values);
+					}
+					mins[j] = horizontalMin(min);
+					maxs[j] = horizontalMax(max);
+				}
+			}
+			i = end;
+		}
+		#endif // GENO_SIMD_SSE
+		for (; i < job.end; ++i) {
+			float vert[] = { x(stream, i), y(stream, i), z(stream, i) };
+			for (uint32 j = 0; j < 3; ++j) {
+				mins[j] = vert[j] < mins[j] ? vert[j] : mins[j];
+				maxs[j] = vert[j] > maxs[j] ? vert[j] : maxs[j];
+			}
+		}
+		for (uint32 j = 0; j < 3; ++j) {
+			job.out[j    ] = mins[j];
+			job.out[j + 3] = maxs[j];
+		}
+	}
+
+	void sphereKernel(void * data) {
+		GenoBoundsJob & job = *((GenoBoundsJob *) data);
+		const GenoVertexStream & stream = *job.stream;
+		float maxDistance = 0;
+		uint32 i = job.begin;
+		#ifdef GENO_SIMD_SSE
+		uint32 end = job.begin + ((job.end - job.begin) & ~3u);
+		__m128 centerX = _mm_set1_ps(job.params[0]);
+		__m128 centerY = _mm_set1_ps(job.params[1]);
+		__m128 centerZ = _mm_set1_ps(job.params[2]);
+		__m128 max = _mm_setzero_ps();
+		for (; i < end; i += 4) {
+			__m128 dx, dy, dz;
+			if (stream.verts != 0) {
+				const float * verts = stream.verts + i * stream.stride;
+				dx = _mm_sub_ps(gather(verts,     stream.stride), centerX);
+				dy = _mm_sub_ps(gather(verts + 1, stream.stride), centerY);
+				dz = _mm_sub_ps(gather(verts + 2, stream.stride), centerZ);
+			}
+			else {
+				dx = _mm_sub_ps(_mm_loadu_ps(stream.xs + i), centerX);
+				dy = _mm_sub_ps(_mm_loadu_ps(stream.ys + i), centerY);
+				dz = _mm_sub_ps(_mm_loadu_ps(stream.zs + i), centerZ);
+			}
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			max = _mm_max_ps(max, distance);
+		}
+		maxDistance = horizontalMax(max);
+		#endif // GENO_SIMD_SSE
+		for (; i < job.end; ++i) {
+			float dx = x(stream, i) - job.params[0];
+			float dy = y(stream, i) - job.params[1];
+			float dz = z(stream, i) - job.params[2];
+			float distance = dx * dx + dy * dy + dz * dz;
+			maxDistance = distance > maxDistance ? distance : maxDistance;
+		}
+		job.out[0] = maxDistance;
+	}
+
+	void meanKernel(void * data) {
+		GenoBoundsJob & job = *((GenoBoundsJob *) data);
+		const GenoVertexStream & stream = *job.stream;
+		double sumX = 0;
+		double sumY = 0;
+		for (uint32 i = job.begin; i < job.end; ++i) {
+			sumX += x(stream, i);
+			sumY += y(stream, i);
+		}
+		job.sums[0] = sumX;
+		job.sums[1] = sumY;
+	}
+
+	void covarianceKernel(void * data) {
+		GenoBoundsJob & job = *((GenoBoundsJob *) data);
+		const GenoVertexStream & stream = *job.stream;
+		double sumXX = 0;
+		double sumXY = 0;
+		double sumYY = 0;
+		for (uint32 i = job.begin; i < job.end; ++i) {
+			double dx = x(stream, i) - job.params[0];
+			double dy = y(stream, i) - job.params[1];
+			sumXX += dx * dx;
+			sumXY += dx * dy;
+			sumYY += dy * dy;
+		}
+		job.sums[0] = sumXX;
+		job.sums[1] = sumXY;
+		job.sums[2] = sumYY;
+	}
+
+	void projectKernel(void * data) {
+		GenoBoundsJob & job = *((GenoBoundsJob *) data);
+		const GenoVertexStream & stream = *job.stream;
+		float cosAxis = job.params[0];
+		float sinAxis = job.params[1];
+		uint32 i = job.begin;
+		float u = x(stream, i) * cosAxis + y(stream, i) * sinAxis;
+		float v = y(stream, i) * cosAxis - x(stream, i) * sinAxis;
+		float minU = u, maxU = u, minV = v, maxV = v;
+		#ifdef GENO_SIMD_SSE
+		uint32 end = job.begin + ((job.end - job.begin) & ~3u);
+		if (end > job.begin) {
+			__m128 cosAxes = _mm_set1_ps(cosAxis);
+			__m128 sinAxes = _mm_set1_ps(sinAxis);
+			__m128 minUs = _mm_set1_ps(u), maxUs = minUs;
+			__m128 minVs = _mm_set1_ps(v), maxVs = minVs;
+			for (; i < end; i += 4) {
+				__m128 xs, ys;
+				if (stream.verts != 0) {
+					xs = gather(stream.verts + i * stream.stride,     stream.stride);
+					ys = gather(stream.verts + i * stream.stride + 1, stream.stride);
+				}
+				else {
+					xs = _mm_loadu_ps(stream.xs + i);
+					ys = _mm_loadu_ps(stream.ys + i);
+				}
+				__m128 us = _mm_add_ps(_mm_mul_ps(xs, cosAxes), _mm_mul_ps(ys, sinAxes));
+				__m128 vs = _mm_sub_ps(_mm_mul_ps(ys, cosAxes), _mm_mul_ps(xs, sinAxes));
+				minUs = _mm_min_ps(minUs, us);
+				maxUs = _mm_max_ps(maxUs, us);
+				minVs = _mm_min_ps(minVs, vs);
+				maxVs = _mm_max_ps(maxVs, vs);
+			}
+			minU = horizontalMin(minUs);
+			maxU = horizontalMax(maxUs);
+			minV = horizontalMin(minVs);
+			maxV = horizontalMax(maxVs);
+		}
+		#endif // GENO_SIMD_SSE
+		for (; i < job.end; ++i) {
+			u = x(stream, i) * cosAxis + y(stream, i) * sinAxis;
+			v = y(stream, i) * cosAxis - x(stream, i) * sinAxis;
+			minU = u < minU ? u : minU;
+			maxU = u > maxU ? u : maxU;
+			minV = v < minV ? v : minV;
+			maxV = v > maxV ? v : maxV;
+		}
+		job.out[0] = minU;
+		job.out[1] = maxU;
+		job.out[2] = minV;
+		job.out[3] = maxV;
+	}
+
+	uint32 chunkCount(uint32 num, GenoThreadPool * pool) {
+		if (pool == 0 || num < GENO_BOUNDS_PARALLEL_THRESHOLD || pool->getThreadCount() < 2)
+			return 1;
+		return pool->getThreadCount() < GENO_BOUNDS_MAX_CHUNKS ? pool->getThreadCount() : GENO_BOUNDS_MAX_CHUNKS;
+	}
+
+	uint32 run(GenoThreadPoolJob kernel, const GenoBoundsJob & base, GenoBoundsJob * jobs, uint32 num, GenoThreadPool * pool) {
+		uint32 count = chunkCount(num, pool);
+		uint32 chunk = num / count;
+		for (uint32 i = 0; i < count; ++i) {
+			jobs[i] = base;
+			jobs[i].begin = i * chunk;
+			jobs[i].end   = i == count - 1 ? num : (i + 1) * chunk;
+		}
+		if (count == 1)
+			kernel(jobs);
+		else {
+			GenoJobCounter counter;
+			for (uint32 i = 0; i < count; ++i)
+				pool->submitJob(counter, kernel, jobs + i);
+			pool->wait(counter);
+		}
+		return count;
+	}
+
+	GenoAabb computeAabb(const GenoVertexStream & stream, uint32 num, GenoThreadPool * pool) {
+		GenoAabb ret = {};
+		if (num == 0)
+			return ret;
+		GenoBoundsJob base = {};
+		base.stream = &stream;
+		GenoBoundsJob jobs[GENO_BOUNDS_MAX_CHUNKS];
+		uint32 count = run(aabbKernel, base, jobs, num, pool);
+		for (uint32 j = 0; j < 3; ++j) {
+			ret.min[j] = jobs[0].out[j    ];
+			ret.max[j] = jobs[0].out[j + 3];
+		}
+		for (uint32 i = 1; i < count; ++i) {
+			for (uint32 j = 0; j < 3; ++j) {
+				ret.min[j] = jobs[i].out[j    ] < ret.min[j] ? jobs[i].out[j    ] : ret.min[j];
+				ret.max[j] = jobs[i].out[j + 3] > ret.max[j] ? jobs[i].out[j + 3] : ret.max[j];
+			}
+		}
+		return ret;
+	}
+
+	GenoBoundingSphere computeSphere(const GenoAabb & aabb, const GenoVertexStream & stream, uint32 num, GenoThreadPool * pool) {
+		GenoBoundingSphere ret = {};
+		for (uint32 j = 0; j < 3; ++j)
+			ret.center[j] = (aabb.min[j] + aabb.max[j]) * 0.5f;
+		if (num == 0)
+			return ret;
+		GenoBoundsJob base = {};
+		base.stream = &stream;
+		base.params[0] = ret.center[0];
+		base.params[1] = ret.center[1];
+		base.params[2] = ret.center[2];
+		GenoBoundsJob jobs[GENO_BOUNDS_MAX_CHUNKS];
+		uint32 count = run(sphereKernel, base, jobs, num, pool);
+		float maxDistance = 0;
+		for (uint32 i = 0; i < count; ++i)
+			maxDistance = jobs[i].out[0] > maxDistance ? jobs[i].out[0] : maxDistance;
+		ret.radius = std::sqrt(maxDistance);
+		return ret;
+	}
+
+	GenoObb2D computeObb2D(const GenoVertexStream & stream, uint32 num, GenoThreadPool * pool) {
+		GenoObb2D ret = {};
+		ret.axis[0] = 1;
+		if (num == 0)
+			return ret;
+		GenoBoundsJob base = {};
+		base.stream = &stream;
+		GenoBoundsJob jobs[GENO_BOUNDS_MAX_CHUNKS];
+
+		uint32 count = run(meanKernel, base, jobs, num, pool);
+		double sumX = 0;
+		double sumY = 0;
+		for (uint32 i = 0; i < count; ++i) {
+			sumX += jobs[i].sums[0];
+			sumY += jobs[i].sums[1];
+		}
+		base.params[0] = (float) (sumX / num);
+		base.params[1] = (float) (sumY / num);
+
+		count = run(covarianceKernel, base, jobs, num, pool);
+		double sumXX = 0;
+		double sumXY = 0;
+		double sumYY = 0;
+		for (uint32 i = 0; i < count; ++i) {
+			sumXX += jobs[i].sums[0];
+			sumXY += jobs[i].sums[1];
+			sumYY += jobs[i].sums[2];
+		}
+
+		// Principal axis of the covariance matrix
+		double angle = 0.5 * std::atan2(2 * sumXY, sumXX - sumYY);
+		float cosAxis = (float) std::cos(angle);
+		float sinAxis = (float) std::sin(angle);
+		base.params[0] = cosAxis;
+		base.params[1] = sinAxis;
+
+		count = run(projectKernel, base, jobs, num, pool);
+		float minU = jobs[0].out[0], maxU = jobs[0].out[1], minV = jobs[0].out[2], maxV = jobs[0].out[3];
+		for (uint32 i = 1; i < count; ++i) {
+			minU = jobs[i].out[0] < minU ? jobs[i].out[0] : minU;
+			maxU = jobs[i].out[1] > maxU ? jobs[i].out[1] : maxU;
+			minV = jobs[i].out[2] < minV ? jobs[i].out[2] : minV;
+			maxV = jobs[i].out[3] > maxV ? jobs[i].out[3] : maxV;
+		}
+
+		float centerU = (minU + maxU) * 0.5f;
+		float centerV = (minV + maxV) * 0.5f;
+		ret.center[0]      = centerU * cosAxis - centerV * sinAxis;
+		ret.center[1]      = centerU * sinAxis + centerV * cosAxis;
+		ret.axis[0]        = cosAxis;
+		ret.axis[1]        = sinAxis;
+		ret.halfExtents[0] = (maxU - minU) * 0.5f;
+		ret.halfExtents[1] = (maxV - minV) * 0.5f;
+		return ret;
+	}
+}
+
+GenoAabb GenoBounds::computeAabb(uint32 num, const float verts[], uint32 stride, GenoThreadPool * pool) {
+	GenoVertexStream stream = { verts, stride, 0, 0, 0 };
+	return ::computeAabb(stream, num, pool);
+}
+
+GenoAabb GenoBounds::computeAabb(uint32 num, const float xs[], const float ys[], const float zs[], GenoThreadPool * pool) {
+	GenoVertexStream stream = { 0, 1, xs, ys, zs };
+	return ::computeAabb(stream, num, pool);
+}
+
+GenoBoundingSphere GenoBounds::computeSphere(uint32 num, const float verts[], uint32 stride, GenoThreadPool * pool) {
+	GenoVertexStream stream = { verts, stride, 0, 0, 0 };
+	return ::computeSphere(::computeAabb(stream, num, pool), stream, num, pool);
+}
+
+GenoBoundingSphere GenoBounds::computeSphere(uint32 num, const float xs[], const float ys[], const float zs[], GenoThreadPool * pool) {
+	GenoVertexStream stream = { 0, 1, xs, ys, zs };
+	return ::computeSphere(::computeAabb(stream, num, pool), stream, num, pool);
+}
+
+GenoBoundingSphere GenoBounds::computeSphere(const GenoAabb & aabb, uint32 num, const float verts[], uint32 stride, GenoThreadPool * pool) {
+	GenoVertexStream stream = { verts, stride, 0, 0, 0 };
+	return ::computeSphere(aabb, stream, num, pool);
+}
+
+GenoObb2D GenoBounds::computeObb2D(uint32 num, const float verts[], uint32 stride, GenoThreadPool * pool) {
+	GenoVertexStream stream = { verts, stride, 0, 0, 0 };
+	return ::computeObb2D(stream, num, pool);
+}
+
+GenoObb2D GenoBounds::computeObb2D(uint32 num, const float xs[], const float ys[], GenoThreadPool * pool) {
+	GenoVertexStream stream = { 0, 1, xs, ys, 0 };
+	return ::computeObb2D(stream, num, pool);
+}
+
+GenoBounds::GenoBounds() {}
+GenoBounds::~GenoBounds() {}
\ No newline at end of file
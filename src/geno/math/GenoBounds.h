@@ -0,0 +1,120 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_THREAD_POOL_FORWARD
+#define GNARLY_GENOME_THREAD_POOL_FORWARD
+
+class GenoThreadPool;
+
+#endif // GNARLY_GENOME_THREAD_POOL_FORWARD
+
+#ifndef GNARLY_GENOME_BOUNDS
+#define GNARLY_GENOME_BOUNDS
+
+#include "../GenoInts.h"
+
+/**
+ * Vertex counts at or above this are split across the thread pool when one is provided
+**/
+#define GENO_BOUNDS_PARALLEL_THRESHOLD 0x10000
+
+struct GenoAabb {
+	float min[3];
+	float max[3];
+};
+
+struct GenoBoundingSphere {
+	float center[3];
+	float radius;
+};
+
+struct GenoObb2D {
+	float center[2];
+	float axis[2];
+	float halfExtents[2];
+};
+
+/**
+ * Bounding volume computation over raw vertex streams
+ *
+ * Interleaved streams take a stride in floats (at least 3 for 3D volumes, at least 2 for 2D volumes)
+ * with the position in the first components of each vertex. SoA streams take one array per axis.
+**/
+class GenoBounds final {
+	private:
+		GenoBounds();
+		~GenoBounds();
+	public:
+
+		/**
+		 * Computes the axis aligned bounding box of an interleaved vertex stream
+		 *
+		 * @param num - The number of vertices
+		 * @param verts - The vertex stream
+		 * @param stride - The number of floats between consecutive vertices
+		 * @param pool - The thread pool to split large streams across, can be null
+		**/
+		static GenoAabb computeAabb(uint32 num, const float verts[], uint32 stride = 3, GenoThreadPool * pool = 0);
+
+		/**
+		 * Computes the axis aligned bounding box of an SoA vertex stream
+		 *
+		 * @param num - The number of vertices
+		 * @param xs, ys, zs - The vertex components
+		 * @param pool - The thread pool to split large streams across, can be null
+		**/
+		static GenoAabb computeAabb(uint32 num, const float xs[], const float ys[], const float zs[], GenoThreadPool * pool = 0);
+
+		/**
+		 * Computes a bounding sphere of an interleaved vertex stream centered on its bounding box
+		**/
+		static GenoBoundingSphere computeSphere(uint32 num, const float verts[], uint32 stride = 3, GenoThreadPool * pool = 0);
+
+		/**
+		 * Computes a bounding sphere of an SoA vertex stream centered on its bounding box
+		**/
+		static GenoBoundingSphere computeSphere(uint32 num, const float xs[], const float ys[], const float zs[], GenoThreadPool * pool = 0);
+
+		/**
+		 * Computes a bounding sphere around a previously computed bounding box
+		**/
+		static GenoBoundingSphere computeSphere(const GenoAabb & aabb, uint32 num, const float verts[], uint32 stride = 3, GenoThreadPool * pool = 0);
+
+		/**
+		 * Computes an oriented bounding rectangle of the xy components of an interleaved vertex stream
+		 *
+		 * The box is aligned to the principal axes of the vertices
+		**/
+		static GenoObb2D computeObb2D(uint32 num, const float verts[], uint32 stride = 3, GenoThreadPool * pool = 0);
+
+		/**
+		 * Computes an oriented bounding rectangle of an SoA vertex stream
+		**/
+		static GenoObb2D computeObb2D(uint32 num, const float xs[], const float ys[], GenoThreadPool * pool = 0);
+};
+
+#define GNARLY_GENOME_BOUNDS_FORWARD
+#endif // GNARLY_GENOME_BOUNDS
\ No newline at end of file
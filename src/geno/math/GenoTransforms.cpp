@@ -0,0 +1,217 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include <cmath>
+
+#include "GenoSimd.h"
+
+#include "GenoTransforms.h"
+
+namespace {
+	#ifdef GENO_SIMD_SSE
+	/**
+	 * Computes the sine and cosine of four angles with one shared range reduction
+	**/
+	void sinCos(__m128 angles, __m128 & sines, __m128 & cosines) {
+		const __m128 twoOverPi = _mm_set1_ps(0.636619772367581343f);
+
+		// Reduces to [-pi / 4, pi / 4] around the nearest multiple of pi / 2, subtracting pi / 2 in three parts to keep precision
+		__m128i quadrants = _mm_cvtps_epi32(_mm_mul_ps(angles, twoOverPi));
+		__m128  k = _mm_cvtepi32_ps(quadrants);
+		__m128  r = _mm_sub_ps(angles, _mm_mul_ps(k, _mm_set1_ps(1.5703125f)));
+		r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(4.837512969970703125e-4f)));
+		r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(7.54978995489188216e-8f)));
+		__m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 sinR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+		sinR = _mm_add_ps(_mm_mul_ps(sinR, r2), _mm_set1_ps(-1.6666654611e-1f));
+		sinR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinR, r2), r), r);
+
+		__m128 cosR = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+		cosR = _mm_add_ps(_mm_mul_ps(cosR, r2), _mm_set1_ps(4.166664568298827e-2f));
+		cosR = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cosR, r2), r2), _mm_sub_ps(_mm_set1_ps(1), _mm_mul_ps(r2, _mm_set1_ps(0.5f))));
+
+		// Odd quadrants swap sine and cosine, the sign of each follows the quadrant
+		__m128i one = _mm_set1_epi32(1);
+		__m128i two = _mm_set1_epi32(2);
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrants, one), one));
+		__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrants, two), 30));
+		__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrants, one), two), 30));
+		sines   = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR)), sinSign);
+		cosines = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR)), cosSign);
+	}
+
+	void storeColumns(float * output, uint32 stride, uint32 offset, __m128 a, __m128 b, __m128 c, __m128 d) {
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(output              + offset, a);
+		_mm_storeu_ps(output + stride     + offset, b);
+		_mm_storeu_ps(output + stride * 2 + offset, c);
+		_mm_storeu_ps(output + stride * 3 + offset, d);
+	}
+	#endif // GENO_SIMD_SSE
+
+	void writeMatrix4(float * m, float a, float b, float c, float d, float x, float y, float z) {
+		m[0 ] = a; m[1 ] = b; m[2 ] = 0; m[3 ] = 0;
+		m[4 ] = c; m[5 ] = d; m[6 ] = 0; m[7 ] = 0;
+		m[8 ] = 0; m[9 ] = 0; m[10] = 1; m[11] = 0;
+		m[12] = x; m[13] = y; m[14] = z; m[15] = 1;
+	}
+}
+
+void GenoTransforms::composeMatrix4(uint32 num, const GenoTransformArrays2D & transforms, float * output, uint32 stride) {
+	uint32 i = 0;
+	#ifdef GENO_SIMD_SSE
+	__m128 zero = _mm_setzero_ps();
+	__m128 one  = _mm_set1_ps(1);
+	__m128 unitZ = _mm_set_ps(0, 1, 0, 0);
+	for (; i + 4 <= num; i += 4) {
+		__m128 sines, cosines;
+		sinCos(_mm_loadu_ps(transforms.rotations + i), sines, cosines);
+		__m128 scaleXs = _mm_loadu_ps(transforms.scaleXs + i);
+		__m128 scaleYs = _mm_loadu_ps(transforms.scaleYs + i);
+		__m128 zs = transforms.zs != 0 ? _mm_loadu_ps(transforms.zs + i) : zero;
+		float * m = output + i * stride;
+		storeColumns(m, stride, 0, _mm_mul_ps(cosines, scaleXs), _mm_mul_ps(sines, scaleXs), zero, zero);
+		storeColumns(m, stride, 4, _mm_sub_ps(zero, _mm_mul_ps(sines, scaleYs)), _mm_mul_ps(cosines, scaleYs), zero, zero);
+		_mm_storeu_ps(m              + 8, unitZ);
+		_mm_storeu_ps(m + stride     + 8, unitZ);
+		_mm_storeu_ps(m + stride * 2 + 8, unitZ);
+		_mm_storeu_ps(m + stride * 3 + 8, unitZ);
+		storeColumns(m, stride, 12, _mm_loadu_ps(transforms.xs + i), _mm_loadu_ps(transforms.ys + i), zs, one);
+	}
+	#endif // GENO_SIMD_SSE
+	for (; i < num; ++i) {
+		float sine   = std::sin(transforms.rotations[i]);
+		float cosine = std::cos(transforms.rotations[i]);
+		writeMatrix4(output + i * stride,
+		             cosine * transforms.scaleXs[i],  sine   * transforms.scaleXs[i],
+		            -sine   * transforms.scaleYs[i],  cosine * transforms.scaleYs[i],
+		             transforms.xs[i], transforms.ys[i], transforms.zs != 0 ? transforms.zs[i] : 0);
+	}
+}
+
+void GenoTransforms::composeAffine2(uint32 num, const GenoTransformArrays2D & transforms, float * output, uint32 stride) {
+	uint32 i = 0;
+	#ifdef GENO_SIMD_SSE
+	__m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= num; i += 4) {
+		__m128 sines, cosines;
+		sinCos(_mm_loadu_ps(transforms.rotations + i), sines, cosines);
+		__m128 scaleXs = _mm_loadu_ps(transforms.scaleXs + i);
+		__m128 scaleYs = _mm_loadu_ps(transforms.scaleYs + i);
+		float * m = output + i * stride;
+		storeColumns(m, stride, 0,
+		             _mm_mul_ps(cosines, scaleXs),
+		             _mm_mul_ps(sines,   scaleXs),
+		             _mm_sub_ps(zero, _mm_mul_ps(sines, scaleYs)),
+		             _mm_mul_ps(cosines, scaleYs));
+		__m128 xs = _mm_loadu_ps(transforms.xs + i);
+		__m128 ys = _mm_loadu_ps(transforms.ys + i);
+		__m128 low  = _mm_unpacklo_ps(xs, ys);
+		__m128 high = _mm_unpackhi_ps(xs, ys);
+		_mm_storel_pi((__m64 *) (m              + 4), low);
+		_mm_storeh_pi((__m64 *) (m + stride     + 4), low);
+		_mm_storel_pi((__m64 *) (m + stride * 2 + 4), high);
+		_mm_storeh_pi((__m64 *) (m + stride * 3 + 4), high);
+	}
+	#endif // GENO_SIMD_SSE
+	for (; i < num; ++i) {
+		float sine   = std::sin(transforms.rotations[i]);
+		float cosine = std::cos(transforms.rotations[i]);
+		float * m = output + i * stride;
+		m[0] =  cosine * transforms.scaleXs[i];
+		m[1] =  sine   * transforms.scaleXs[i];
+		m[2] = -sine   * transforms.scaleYs[i];
+		m[3] =  cosine * transforms.scaleYs[i];
+		m[4] =  transforms.xs[i];
+		m[5] =  transforms.ys[i];
+	}
+}
+
+void GenoTransforms::composeMatrix4(uint32 num, const GenoTransformArrays3D & transforms, float * output, uint32 stride) {
+	uint32 i = 0;
+	#ifdef GENO_SIMD_SSE
+	__m128 zero = _mm_setzero_ps();
+	__m128 one  = _mm_set1_ps(1);
+	__m128 two  = _mm_set1_ps(2);
+	for (; i + 4 <= num; i += 4) {
+		__m128 x = _mm_loadu_ps(transforms.rotationXs + i);
+		__m128 y = _mm_loadu_ps(transforms.rotationYs + i);
+		__m128 z = _mm_loadu_ps(transforms.rotationZs + i);
+		__m128 w = _mm_loadu_ps(transforms.rotationWs + i);
+		__m128 x2 = _mm_mul_ps(x, two);
+		__m128 y2 = _mm_mul_ps(y, two);
+		__m128 z2 = _mm_mul_ps(z, two);
+		__m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+		__m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+		__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+		__m128 scaleXs = _mm_loadu_ps(transforms.scaleXs + i);
+		__m128 scaleYs = _mm_loadu_ps(transforms.scaleYs + i);
+		__m128 scaleZs = _mm_loadu_ps(transforms.scaleZs + i);
+		float * m = output + i * stride;
+		storeColumns(m, stride, 0,
+		             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scaleXs),
+		             _mm_mul_ps(_mm_add_ps(xy, wz), scaleXs),
+		             _mm_mul_ps(_mm_sub_ps(xz, wy), scaleXs),
+		             zero);
+		storeColumns(m, stride, 4,
+		             _mm_mul_ps(_mm_sub_ps(xy, wz), scaleYs),
+		             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scaleYs),
+		             _mm_mul_ps(_mm_add_ps(yz, wx), scaleYs),
+		             zero);
+		storeColumns(m, stride, 8,
+		             _mm_mul_ps(_mm_add_ps(xz, wy), scaleZs),
+		             _mm_mul_ps(_mm_sub_ps(yz, wx), scaleZs),
+		             _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scaleZs),
+		             zero);
+		storeColumns(m, stride, 12,
+		             _mm_loadu_ps(transforms.xs + i),
+		             _mm_loadu_ps(transforms.ys + i),
+		             _mm_loadu_ps(transforms.zs + i),
+		             one);
+	}
+	#endif // GENO_SIMD_SSE
+	for (; i < num; ++i) {
+		float x = transforms.rotationXs[i];
+		float y = transforms.rotationYs[i];
+		float z = transforms.rotationZs[i];
+		float w = transforms.rotationWs[i];
+		float xx = 2 * x * x, yy = 2 * y * y, zz = 2 * z * z;
+		float xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z;
+		float wx = 2 * w * x, wy = 2 * w * y, wz = 2 * w * z;
+		float scaleX = transforms.scaleXs[i];
+		float scaleY = transforms.scaleYs[i];
+		float scaleZ = transforms.scaleZs[i];
+		float * m = output + i * stride;
+		m[0 ] = (1 - yy - zz) * scaleX; m[1 ] = (xy + wz) * scaleX;     m[2 ] = (xz - wy) * scaleX;     m[3 ] = 0;
+		m[4 ] = (xy - wz) * scaleY;     m[5 ] = (1 - xx - zz) * scaleY; m[6 ] = (yz + wx) * scaleY;     m[7 ] = 0;
+		m[8 ] = (xz + wy) * scaleZ;     m[9 ] = (yz - wx) * scaleZ;     m[10] = (1 - xx - yy) * scaleZ; m[11] = 0;
+		m[12] = transforms.xs[i];       m[13] = transforms.ys[i];       m[14] = transforms.zs[i];       m[15] = 1;
+	}
+}
+
+GenoTransforms::GenoTransforms() {}
+GenoTransforms::~GenoTransforms() {}
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_TRANSFORMS
+#define GNARLY_GENOME_TRANSFORMS
+
+#include "../GenoInts.h"
+
+#define GENO_TRANSFORMS_MATRIX4_STRIDE 16
+#define GENO_TRANSFORMS_AFFINE2_STRIDE 6
+
+/**
+ * SoA position, rotation and scale arrays of 2D transforms
+ *
+ * zs is optional and defaults to 0 when null
+**/
+struct GenoTransformArrays2D {
+	const float * xs;
+	const float * ys;
+	const float * zs;
+	const float * rotations;
+	const float * scaleXs;
+	const float * scaleYs;
+};
+
+/**
+ * SoA position, unit quaternion rotation and scale arrays of 3D transforms
+**/
+struct GenoTransformArrays3D {
+	const float * xs;
+	const float * ys;
+	const float * zs;
+	const float * rotationXs;
+	const float * rotationYs;
+	const float * rotationZs;
+	const float * rotationWs;
+	const float * scaleXs;
+	const float * scaleYs;
+	const float * scaleZs;
+};
+
+/**
+ * Batch composition of translate * rotate * scale transforms
+ *
+ * Every transform is written straight into the output array, stride floats apart, so the output
+ * can be a mapped instance buffer or uniform block. Matrices are column major to match GenoMatrix4f.
+**/
+class GenoTransforms final {
+	private:
+		GenoTransforms();
+		~GenoTransforms();
+	public:
+
+		/**
+		 * Composes 2D transforms into 4x4 matrices
+		 *
+		 * @param num - The number of transforms
+		 * @param transforms - The transform arrays
+		 * @param output - The output array
+		 * @param stride - The number of floats between consecutive matrices in the output
+		**/
+		static void composeMatrix4(uint32 num, const GenoTransformArrays2D & transforms, float * output, uint32 stride = GENO_TRANSFORMS_MATRIX4_STRIDE);
+
+		/**
+		 * Composes 2D transforms into 3x2 affine matrices
+		 *
+		 * @param num - The number of transforms
+		 * @param transforms - The transform arrays
+		 * @param output - The output array
+		 * @param stride - The number of floats between consecutive matrices in the output
+		**/
+		static void composeAffine2(uint32 num, const GenoTransformArrays2D & transforms, float * output, uint32 stride = GENO_TRANSFORMS_AFFINE2_STRIDE);
+
+		/**
+		 * Composes 3D transforms into 4x4 matrices
+		 *
+		 * @param num - The number of transforms
+		 * @param transforms - The transform arrays
+		 * @param output - The output array
+		 * @param stride - The number of floats between consecutive matrices in the output
+		**/
+		static void composeMatrix4(uint32 num, const GenoTransformArrays3D & transforms, float * output, uint32 stride = GENO_TRANSFORMS_MATRIX4_STRIDE);
+};
+
+#define GNARLY_GENOME_TRANSFORMS_FORWARD
+#endif // GNARLY_GENOME_TRANSFORMS
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_AFFINE2
+#define GNARLY_GENOME_AFFINE2
+
+#include <ostream>
+#include <cmath>
+
+#include "../../GenoInts.h"
+#include "../GenoSimd.h"
+#include "GenoVector2.h"
+#include "GenoMatrix4.h"
+
+/**
+ * A 2D affine transform stored as a column major 3x2 matrix
+ *
+ * The six floats are stored inline in the order of a GLSL mat3x2, so an array of GenoAffine2
+ * can be uploaded directly and a transform costs 12 multiplies instead of 64
+**/
+class GenoAffine2 {
+	public:
+		float m[6];
+
+		static GenoAffine2 makeIdentity() {
+			return { 1, 0, 0, 1, 0, 0 };
+		}
+
+		static GenoAffine2 makeTranslate(float translateX, float translateY) {
+			return { 1, 0, 0, 1, translateX, translateY };
+		}
+
+		static GenoAffine2 makeTranslate(const GenoVector<2, float> & translate) {
+			return { 1, 0, 0, 1, translate.v[0], translate.v[1] };
+		}
+
+		static GenoAffine2 makeRotate(float rotate) {
+			float sinR = std::sin(rotate);
+			float cosR = std::cos(rotate);
+			return { cosR, sinR, -sinR, cosR, 0, 0 };
+		}
+
+		static GenoAffine2 makeScale(float scaleX, float scaleY) {
+			return { scaleX, 0, 0, scaleY, 0, 0 };
+		}
+
+		static GenoAffine2 makeScale(const GenoVector<2, float> & scale) {
+			return { scale.v[0], 0, 0, scale.v[1], 0, 0 };
+		}
+
+		/**
+		 * Returns translate * rotate * scale without building the intermediate transforms
+		**/
+		static GenoAffine2 makeTRS(float translateX, float translateY, float rotate, float scaleX, float scaleY) {
+			float sinR = std::sin(rotate);
+			float cosR = std::cos(rotate);
+			return { cosR * scaleX, sinR * scaleX, -sinR * scaleY, cosR * scaleY, translateX, translateY };
+		}
+
+		/**
+		 * Returns the xy part of an orthographic projection
+		**/
+		static GenoAffine2 makeOrthographic(float left, float right, float bottom, float top) {
+			return {
+				2 / (right - left), 0,
+				0, 2 / (top - bottom),
+				(left + right) / (left - right), (bottom + top) / (bottom - top)
+			};
+		}
+
+		/**
+		 * Writes left * right into target, target may alias either operand
+		**/
+		static void compose(const GenoAffine2 & left, const GenoAffine2 & right, GenoAffine2 & target) {
+			#ifdef GENO_SIMD_SSE
+			__m128 l  = _mm_loadu_ps(left.m);
+			__m128 r  = _mm_loadu_ps(right.m);
+			__m128 lt = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (left.m  + 4));
+			__m128 rt = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (right.m + 4));
+			__m128 column0 = _mm_movelh_ps(l, l);
+			__m128 column1 = _mm_movehl_ps(l, l);
+			__m128 linear = _mm_add_ps(_mm_mul_ps(column0, _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 0, 0))),
+			                           _mm_mul_ps(column1, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 1, 1))));
+			__m128 translate = _mm_add_ps(_mm_add_ps(_mm_mul_ps(column0, _mm_shuffle_ps(rt, rt, _MM_SHUFFLE(0, 0, 0, 0))),
+			                                         _mm_mul_ps(column1, _mm_shuffle_ps(rt, rt, _MM_SHUFFLE(1, 1, 1, 1)))), lt);
+			_mm_storeu_ps(target.m, linear);
+			_mm_storel_pi((__m64 *) (target.m + 4), translate);
+			#else
+			float newM[] = {
+				left.m[0] * right.m[0] + left.m[2] * right.m[1],
+				left.m[1] * right.m[0] + left.m[3] * right.m[1],
+				left.m[0] * right.m[2] + left.m[2] * right.m[3],
+				left.m[1] * right.m[2] + left.m[3] * right.m[3],
+				left.m[0] * right.m[4] + left.m[2] * right.m[5] + left.m[4],
+				left.m[1] * right.m[4] + left.m[3] * right.m[5] + left.m[5]
+			};
+			target.m[0] = newM[0]; target.m[1] = newM[1]; target.m[2] = newM[2];
+			target.m[3] = newM[3]; target.m[4] = newM[4]; target.m[5] = newM[5];
+			#endif // GENO_SIMD_SSE
+		}
+
+		/**
+		 * Composes left with each of the rights, writing left * rights[i] into targets[i]
+		**/
+		static void compose(uint32 num, const GenoAffine2 & left, const GenoAffine2 rights[], GenoAffine2 targets[]) {
+			for (uint32 i = 0; i < num; ++i)
+				compose(left, rights[i], targets[i]);
+		}
+
+		GenoAffine2 & operator*=(const GenoAffine2 & affine) {
+			compose(*this, affine, *this);
+			return *this;
+		}
+
+		/**
+		 * Inverts the transform in place, the transform is left unchanged if it is singular
+		 *
+		 * @return - Whether the transform was invertible
+		**/
+		bool invert() {
+			float determinant = m[0] * m[3] - m[1] * m[2];
+			if (determinant == 0)
+				return false;
+			float inverse = 1 / determinant;
+			#ifdef GENO_SIMD_SSE
+			__m128 linear = _mm_loadu_ps(m);
+			__m128 t = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (m + 4));
+			linear = _mm_mul_ps(_mm_shuffle_ps(linear, linear, _MM_SHUFFLE(0, 2, 1, 3)), _mm_set_ps(inverse, -inverse, -inverse, inverse));
+			__m128 translate = _mm_sub_ps(_mm_setzero_ps(),
+				_mm_add_ps(_mm_mul_ps(_mm_movelh_ps(linear, linear), _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0))),
+				           _mm_mul_ps(_mm_movehl_ps(linear, linear), _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)))));
+			_mm_storeu_ps(m, linear);
+			_mm_storel_pi((__m64 *) (m + 4), translate);
+			#else
+			float newM[] = {
+				 m[3] * inverse,
+				-m[1] * inverse,
+				-m[2] * inverse,
+				 m[0] * inverse
+			};
+			float translateX = -(newM[0] * m[4] + newM[2] * m[5]);
+			float translateY = -(newM[1] * m[4] + newM[3] * m[5]);
+			m[0] = newM[0]; m[1] = newM[1]; m[2] = newM[2]; m[3] = newM[3];
+			m[4] = translateX;
+			m[5] = translateY;
+			#endif // GENO_SIMD_SSE
+			return true;
+		}
+
+		/**
+		 * Transforms SoA points, the outputs may alias the inputs
+		**/
+		void transformPoints(uint32 num, const float xs[], const float ys[], float outXs[], float outYs[]) const {
+			uint32 i = 0;
+			#ifdef GENO_SIMD_SSE
+			__m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+			__m128 m3 = _mm_set1_ps(m[3]), m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]);
+			for (; i + 4 <= num; i += 4) {
+				__m128 x = _mm_loadu_ps(xs + i);
+				__m128 y = _mm_loadu_ps(ys + i);
+				_mm_storeu_ps(outXs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m2, y)), m4));
+				_mm_storeu_ps(outYs + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m3, y)), m5));
+			}
+			#endif // GENO_SIMD_SSE
+			for (; i < num; ++i) {
+				float x = xs[i];
+				float y = ys[i];
+				outXs[i] = m[0] * x + m[2] * y + m[4];
+				outYs[i] = m[1] * x + m[3] * y + m[5];
+			}
+		}
+
+		/**
+		 * Writes the transform as a column major 4x4 matrix
+		 *
+		 * @param target - The 16 floats to write to
+		 * @param scaleZ - The z scale of the matrix
+		 * @param translateZ - The z translation of the matrix
+		**/
+		void toMatrix4(float * target, float scaleZ = 1, float translateZ = 0) const {
+			target[0 ] = m[0]; target[1 ] = m[1]; target[2 ] = 0;      target[3 ] = 0;
+			target[4 ] = m[2]; target[5 ] = m[3]; target[6 ] = 0;      target[7 ] = 0;
+			target[8 ] = 0;    target[9 ] = 0;    target[10] = scaleZ; target[11] = 0;
+			target[12] = m[4]; target[13] = m[5]; target[14] = translateZ; target[15] = 1;
+		}
+
+		GenoMatrix<4, 4, float> toMatrix4(float scaleZ = 1, float translateZ = 0) const {
+			float * target = new float[4 * 4];
+			toMatrix4(target, scaleZ, translateZ);
+			return target;
+		}
+
+		/**
+		 * Takes the xy part of a 4x4 matrix
+		**/
+		static GenoAffine2 fromMatrix4(const GenoMatrix<4, 4, float> & matrix) {
+			return { matrix.m[0], matrix.m[1], matrix.m[4], matrix.m[5], matrix.m[12], matrix.m[13] };
+		}
+};
+
+static_assert(sizeof(GenoAffine2) == sizeof(float) * 6, "GenoAffine2 must be tightly packed to be uploaded as a mat3x2!");
+
+inline GenoAffine2 operator*(const GenoAffine2 & left, const GenoAffine2 & right) {
+	GenoAffine2 ret;
+	GenoAffine2::compose(left, right, ret);
+	return ret;
+}
+
+inline GenoAffine2 invert(const GenoAffine2 & affine) {
+	GenoAffine2 ret = affine;
+	ret.invert();
+	return ret;
+}
+
+inline std::ostream & operator<<(std::ostream & stream, const GenoAffine2 & affine) {
+	return stream << '[' << affine.m[0] << ", " << affine.m[2] << ", " << affine.m[4] << "]\n"
+	                 "[" << affine.m[1] << ", " << affine.m[3] << ", " << affine.m[5] << "]\n";
+}
+
+#define GNARLY_GENOME_AFFINE2_FORWARD
+#endif // GNARLY_GENOME_AFFINE2
\ No newline at end of file
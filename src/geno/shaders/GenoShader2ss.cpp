@@ -36,7 +36,11 @@ GenoShader2ss::GenoShader2ss() :
 }
 
 void GenoShader2ss::setTextureTransform(const GenoMatrix4f & matrix) {
-	glUniformMatrix4fv(textureTransformLoc, 1, GL_FALSE, matrix.m);
+	setTextureTransform(GenoAffine2::fromMatrix4(matrix));
+}
+
+void GenoShader2ss::setTextureTransform(const GenoAffine2 & affine) {
+	glUniformMatrix3x2fv(textureTransformLoc, 1, GL_FALSE, affine.m);
 }
 
 GenoShader2ss::~GenoShader2ss() {}
\ No newline at end of file
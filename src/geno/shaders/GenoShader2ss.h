@@ -36,6 +36,7 @@ class GenoShader2ss : public GenoMvpShader {
 	public:
 		GenoShader2ss();
 		void setTextureTransform(const GenoMatrix4f & matrix);
+		void setTextureTransform(const GenoAffine2 & affine);
 		~GenoShader2ss();
 };
 
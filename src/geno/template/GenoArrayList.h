@@ -28,26 +28,34 @@
 #define GNARLY_GENOME_ARRAY_LIST
 
 #include <utility>
+#include <type_traits>
 #include <initializer_list>
 
 #include "../GenoInts.h"
 #include "../exceptions/GenoMaxCapacityException.h"
 
-template <typename T>
+/**
+ * S is the type of the capacity, length and indices, uint64 allows lists past 0xFFFFFFFF elements
+**/
+template <typename T, typename S = uint32>
 class GenoArrayList {
 	private:
-		uint32 capacity;
-		uint32 length;
+		static_assert(std::is_integral<S>::value && std::is_unsigned<S>::value, "GenoArrayList size type must be an unsigned integer!");
+
+		constexpr static S MAX_CAPACITY = ~S(0);
+
+		S capacity;
+		S length;
 		T * array;
 
 		void clean() noexcept {
 			delete [] array;
 		}
 
-		void reallocate(uint32 newCapacity) {
+		void reallocate(S newCapacity) {
 			capacity = newCapacity;
 			auto newArray = new T[capacity];
-			for (uint32 i = 0; i < length; ++i)
+			for (S i = 0; i < length; ++i)
 				newArray[i] = std::move(array[i]);
 			clean();
 			array = newArray;
@@ -55,18 +63,21 @@ class GenoArrayList {
 
 		void checkCapacity() {
 			if (length == capacity) {
-				if (capacity == 0xFFFFFFFF)
+				if (capacity == MAX_CAPACITY)
 					throw GenoMaxCapacityException();
-				else if (capacity > 0x7FFFFFFF)
-					reallocate(0xFFFFFFFF);
+				else if (capacity == 0)
+					reallocate(16);
+				else if (capacity > (MAX_CAPACITY >> 1))
+					reallocate(MAX_CAPACITY);
 				else
 					reallocate(capacity << 1);
 			}
 		}
 
 	public:
-		GenoArrayList(uint32 capacity = 16) :
+		GenoArrayList(S capacity = 16) :
 			capacity(capacity),
+			length(0),
 			array(new T[capacity]) {}
 
 		GenoArrayList(std::initializer_list<T> list) :
@@ -74,36 +85,36 @@ class GenoArrayList {
 			length(list.size()),
 			array(new T[capacity]) {
 			auto init = list.begin();
-			for (uint32 i = 0; i < list.size(); ++i)
+			for (S i = 0; i < list.size(); ++i)
 				array[i] = init[i];
 		}
 
-		GenoArrayList(const GenoArrayList<T> & list) :
+		GenoArrayList(const GenoArrayList<T, S> & list) :
 			capacity(list.capacity),
 			length(list.length),
 			array(new T[capacity]) {
-			for (uint32 i = 0; i < list.length; ++i)
+			for (S i = 0; i < list.length; ++i)
 				array[i] = list.array[i];
 		}
 
-		GenoArrayList(GenoArrayList<T> && list) noexcept :
+		GenoArrayList(GenoArrayList<T, S> && list) noexcept :
 			capacity(list.capacity),
 			length(list.length),
 			array(list.array) {
 			list.array = 0;
 		}
 
-		GenoArrayList<T> & operator=(const GenoArrayList<T> & list) {
+		GenoArrayList<T, S> & operator=(const GenoArrayList<T, S> & list) {
 			clean();
 			capacity = list.capacity;
 			length   = list.length;
 			array = new T[capacity];
-			for (uint32 i = 0; i < list.length; ++i)
+			for (S i = 0; i < list.length; ++i)
 				array[i] = list.array[i];
 			return *this;
 		}
 		
-		GenoArrayList<T> & operator=(GenoArrayList<T> && list) noexcept {
+		GenoArrayList<T, S> & operator=(GenoArrayList<T, S> && list) noexcept {
 			clean();
 			capacity = list.capacity;
 			length   = list.length;
@@ -112,15 +123,15 @@ class GenoArrayList {
 			return *this;
 		}
 
-		T & operator[](uint32 index) noexcept {
+		T & operator[](S index) noexcept {
 			return array[index];
 		}
 		
-		const T & operator[](uint32 index) const noexcept {
+		const T & operator[](S index) const noexcept {
 			return array[index];
 		}
 
-		uint32 getLength() const noexcept {
+		S getLength() const noexcept {
 			return length;
 		}
 
@@ -130,24 +141,24 @@ class GenoArrayList {
 			++length;
 		}
 
-		void add(uint32 index, const T & element) {
+		void add(S index, const T & element) {
 			checkCapacity();
-			for (uint32 i = length; i > index; --i)
+			for (S i = length; i > index; --i)
 				array[i] = std::move(array[i - 1]);
 			array[index] = element;
 			++length;
 		}
 
-		void remove(uint32 index) {
+		void remove(S index) {
 			--length;
-			for (uint32 i = index; i < length; ++i)
+			for (S i = index; i < length; ++i)
 				array[i] = std::move(array[i + 1]);
 		}
 
-		void remove(uint32 begin, uint32 end) {
+		void remove(S begin, S end) {
 			auto distance = end - begin;
 			length -= end;
-			for (uint32 i = begin; i < length; ++i)
+			for (S i = begin; i < length; ++i)
 				array[i] = std::move(array[i + distance]);
 		}
 
@@ -164,5 +175,8 @@ class GenoArrayList {
 		}
 };
 
+template <typename T>
+using GenoArrayList64 = GenoArrayList<T, uint64>;
+
 #define GNARLY_GENOME_ARRAY_LIST_FORWARD
 #endif // GNARLY_GENOME_ARRAY_LIST
\ No newline at end of file
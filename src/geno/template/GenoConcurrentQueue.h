@@ -0,0 +1,171 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_CONCURRENT_QUEUE
+#define GNARLY_GENOME_CONCURRENT_QUEUE
+
+#include <atomic>
+#include <utility>
+
+#include "../GenoInts.h"
+
+/**
+ * A bounded lock free multi producer multi consumer queue
+ *
+ * Every slot carries a sequence number telling producers and consumers whose turn it is, so a
+ * thread only ever contends on the position counter it is advancing. Slots are padded to a cache
+ * line so neighbouring producers and consumers do not share lines. The capacity is rounded up
+ * to a power of two and never grows, enqueueing into a full queue fails instead.
+**/
+template <typename T>
+class GenoConcurrentQueue {
+	private:
+		struct alignas(64) GenoConcurrentQueueSlot {
+			std::atomic<uint64> sequence;
+			T element;
+		};
+
+		uint64 mask;
+		GenoConcurrentQueueSlot * slots;
+		alignas(64) std::atomic<uint64> enqueuePosition;
+		alignas(64) std::atomic<uint64> dequeuePosition;
+
+		/**
+		 * Claims up to count positions from position onwards whose slots are at the given turn
+		 *
+		 * @return - The number of positions claimed starting at position
+		**/
+		uint32 claim(std::atomic<uint64> & position, uint64 & start, uint32 count, uint64 turn) {
+			start = position.load(std::memory_order_relaxed);
+			while (true) {
+				uint32 available = 0;
+				while (available < count && slots[(start + available) & mask].sequence.load(std::memory_order_acquire) == start + available + turn)
+					++available;
+				if (available == 0) {
+					// The first slot is behind its turn, so the queue is full or empty unless another thread moved on
+					uint64 current = position.load(std::memory_order_relaxed);
+					if (current == start)
+						return 0;
+					start = current;
+				}
+				// Slot sequences only move once their position is claimed, so the ones checked stay at their turn
+				else if (position.compare_exchange_weak(start, start + available, std::memory_order_relaxed))
+					return available;
+			}
+		}
+
+	public:
+		GenoConcurrentQueue(uint32 capacity = 1024) :
+			enqueuePosition(0),
+			dequeuePosition(0) {
+			uint64 powerOfTwo = 2;
+			while (powerOfTwo < capacity)
+				powerOfTwo <<= 1;
+			mask  = powerOfTwo - 1;
+			slots = new GenoConcurrentQueueSlot[powerOfTwo];
+			for (uint64 i = 0; i < powerOfTwo; ++i)
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		GenoConcurrentQueue(const GenoConcurrentQueue<T> & queue) = delete;
+		GenoConcurrentQueue<T> & operator=(const GenoConcurrentQueue<T> & queue) = delete;
+
+		/**
+		 * Enqueues an element, any thread may enqueue
+		 *
+		 * @return - Whether there was room for the element
+		**/
+		bool tryEnqueue(const T & element) {
+			return tryEnqueue(&element, 1) == 1;
+		}
+
+		/**
+		 * Enqueues as many elements as there is room for in one claim, any thread may enqueue
+		 *
+		 * @param elements - The elements to enqueue in order
+		 * @param count - The number of elements
+		 *
+		 * @return - The number of leading elements that were enqueued
+		**/
+		uint32 tryEnqueue(const T * elements, uint32 count) {
+			uint64 start;
+			uint32 claimed = claim(enqueuePosition, start, count, 0);
+			for (uint32 i = 0; i < claimed; ++i) {
+				GenoConcurrentQueueSlot & slot = slots[(start + i) & mask];
+				slot.element = elements[i];
+				slot.sequence.store(start + i + 1, std::memory_order_release);
+			}
+			return claimed;
+		}
+
+		/**
+		 * Dequeues the oldest element, any thread may dequeue
+		 *
+		 * @return - Whether there was an element to dequeue
+		**/
+		bool tryDequeue(T & element) {
+			return tryDequeue(&element, 1) == 1;
+		}
+
+		/**
+		 * Dequeues as many of the oldest elements as are ready in one claim, any thread may dequeue
+		 *
+		 * @param elements - Filled with the dequeued elements in order
+		 * @param count - The most elements to dequeue
+		 *
+		 * @return - The number of elements dequeued
+		**/
+		uint32 tryDequeue(T * elements, uint32 count) {
+			uint64 start;
+			uint32 claimed = claim(dequeuePosition, start, count, 1);
+			for (uint32 i = 0; i < claimed; ++i) {
+				GenoConcurrentQueueSlot & slot = slots[(start + i) & mask];
+				elements[i] = std::move(slot.element);
+				slot.sequence.store(start + i + mask + 1, std::memory_order_release);
+			}
+			return claimed;
+		}
+
+		/**
+		 * Returns an estimate of the number of elements in the queue
+		**/
+		uint64 getLength() const {
+			uint64 dequeued = dequeuePosition.load(std::memory_order_relaxed);
+			uint64 enqueued = enqueuePosition.load(std::memory_order_relaxed);
+			return enqueued > dequeued ? enqueued - dequeued : 0;
+		}
+
+		uint64 getCapacity() const {
+			return mask + 1;
+		}
+
+		~GenoConcurrentQueue() {
+			delete [] slots;
+		}
+};
+
+#define GNARLY_GENOME_CONCURRENT_QUEUE_FORWARD
+#endif // GNARLY_GENOME_CONCURRENT_QUEUE
\ No newline at end of file
@@ -28,27 +28,35 @@
 #define GNARLY_GENOME_QUEUE
 
 #include <utility>
+#include <type_traits>
 #include <initializer_list>
 
 #include "../GenoInts.h"
 #include "../exceptions/GenoMaxCapacityException.h"
 
-template <typename T>
+/**
+ * S is the type of the capacity, length and indices, uint64 allows queues past 0xFFFFFFFF elements
+**/
+template <typename T, typename S = uint32>
 class GenoQueue {
 	private:
-		uint32 capacity;
-		uint32 read;
-		uint32 write;
-		uint32 length;
+		static_assert(std::is_integral<S>::value && std::is_unsigned<S>::value, "GenoQueue size type must be an unsigned integer!");
+
+		constexpr static S MAX_CAPACITY = ~S(0);
+
+		S capacity;
+		S read;
+		S write;
+		S length;
 		T * array;
 
 		void clean() noexcept {
 			delete [] array;
 		}
 
-		void reallocate(uint32 newCapacity) {
+		void reallocate(S newCapacity) {
 			auto newArray = new T[newCapacity];
-			for (uint32 i = 0, j = read - 1; i < length; ++i)
+			for (S i = 0, j = read - 1; i < length; ++i)
 				newArray[i] = std::move(array[(++j) %= capacity]);
 			clean();
 			capacity = newCapacity;
@@ -59,41 +67,47 @@ class GenoQueue {
 
 		void checkCapacity() {
 			if (length == capacity) {
-				if (capacity == 0xFFFFFFFF)
+				if (capacity == MAX_CAPACITY)
 					throw GenoMaxCapacityException();
-				else if (capacity > 0x7FFFFFFF)
-					reallocate(0xFFFFFFFF);
+				else if (capacity == 0)
+					reallocate(16);
+				else if (capacity > (MAX_CAPACITY >> 1))
+					reallocate(MAX_CAPACITY);
 				else
 					reallocate(capacity << 1);
 			}
 		}
 
 	public:
-		GenoQueue(uint32 capacity = 16) :
+		GenoQueue(S capacity = 16) :
 			capacity(capacity),
+			read(0),
+			write(0),
+			length(0),
 			array(new T[capacity]) {}
 
 		GenoQueue(std::initializer_list<T> list) :
 			capacity(list.size() * 2),
+			read(0),
 			write(list.size()),
 			length(list.size()),
 			array(new T[capacity]) {
 			auto init = list.begin();
-			for (uint32 i = 0; i < list.size(); ++i)
+			for (S i = 0; i < list.size(); ++i)
 				array[i] = init[i];
 		}
 
-		GenoQueue(const GenoQueue<T> & queue) :
+		GenoQueue(const GenoQueue<T, S> & queue) :
 			capacity(queue.capacity),
 			read(queue.read),
 			write(queue.write),
 			length(queue.length),
 			array(new T[capacity]) {
-			for (uint32 i = read; i != write; (++i) %= capacity)
+			for (S i = read; i != write; (++i) %= capacity)
 				array[i] = queue.array[i];
 		}
 
-		GenoQueue(GenoQueue<T> && queue) noexcept :
+		GenoQueue(GenoQueue<T, S> && queue) noexcept :
 			capacity(queue.capacity),
 			read(queue.read),
 			write(queue.write),
@@ -102,17 +116,17 @@ class GenoQueue {
 			queue.array = 0;
 		}
 
-		GenoQueue<T> & operator=(const GenoQueue<T> & queue) {
+		GenoQueue<T, S> & operator=(const GenoQueue<T, S> & queue) {
 			clean();
 			capacity = queue.capacity;
 			length   = queue.length;
 			array = new T[capacity];
-			for (uint32 i = read; i != write; (++i) %= capacity)
+			for (S i = read; i != write; (++i) %= capacity)
 				array[i] = queue.array[i];
 			return *this;
 		}
 		
-		GenoQueue<T> & operator=(GenoQueue<T> && queue) noexcept {
+		GenoQueue<T, S> & operator=(GenoQueue<T, S> && queue) noexcept {
 			clean();
 			capacity = queue.capacity;
 			read     = queue.read;
@@ -123,6 +137,10 @@ class GenoQueue {
 			return *this;
 		}
 
+		S getLength() const noexcept {
+			return length;
+		}
+
 		void enqueue(const T & element) {
 			checkCapacity();
 			array[write] = element;
@@ -131,12 +149,17 @@ class GenoQueue {
 		}
 
 		T dequeue() {
-			uint32 index = read;
+			S index = read;
 			(++read) %= capacity;
 			--length;
 			return std::move(array[index]);
 		}
 
+		void reserve(S minimum) {
+			if (capacity < minimum)
+				reallocate(minimum);
+		}
+
 		void pack() {
 			reallocate(length);
 		}
@@ -146,5 +169,8 @@ class GenoQueue {
 		}
 };
 
+template <typename T>
+using GenoQueue64 = GenoQueue<T, uint64>;
+
 #define GNARLY_GENOME_QUEUE_FORWARD
 #endif // GNARLY_GENOME_QUEUE
\ No newline at end of file
@@ -0,0 +1,288 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_RADIX_SORT
+#define GNARLY_GENOME_RADIX_SORT
+
+#include <cstring>
+#include <type_traits>
+
+#include "../GenoInts.h"
+#include "GenoArrayList.h"
+#include "../thread/GenoThreadPool.h"
+
+/**
+ * Sorts of at least this many keys are split across the thread pool when one is provided
+**/
+#define GENO_RADIX_SORT_PARALLEL_THRESHOLD 0x10000
+
+/**
+ * Parallel sorts give each block at least this many keys
+**/
+#define GENO_RADIX_SORT_MIN_BLOCK 0x4000
+
+/**
+ * Maps other key types onto unsigned integers that sort in the same order
+**/
+class GenoRadixKeys final {
+	private:
+		GenoRadixKeys();
+		~GenoRadixKeys();
+	public:
+		static uint32 fromFloat(float value) {
+			uint32 bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits & 0x80000000 ? ~bits : bits | 0x80000000;
+		}
+
+		static uint64 fromDouble(double value) {
+			uint64 bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits & 0x8000000000000000 ? ~bits : bits | 0x8000000000000000;
+		}
+
+		static uint32 fromInt(int32 value) {
+			return (uint32) value ^ 0x80000000;
+		}
+
+		static uint64 fromInt(int64 value) {
+			return (uint64) value ^ 0x8000000000000000;
+		}
+};
+
+/**
+ * A stable least significant digit radix sort over 32 or 64 bit keys with an optional payload
+ *
+ * Keys are sorted a byte at a time, passes where every key shares the byte are skipped. The sorter
+ * keeps its scratch buffers between sorts so sorting every frame does not allocate once they have
+ * grown to fit. One sorter must not run two sorts at once.
+ *
+ * K is the key type, uint32 or uint64. V is the payload type moved along with the keys.
+**/
+template <typename K, typename V = uint32>
+class GenoRadixSorter {
+	private:
+		static_assert(std::is_same<K, uint32>::value || std::is_same<K, uint64>::value, "GenoRadixSorter keys must be uint32 or uint64!");
+
+		constexpr static uint32 PASSES = sizeof(K);
+		constexpr static uint32 DIGITS = 256;
+
+		uint64 keyCapacity;
+		uint64 valueCapacity;
+		uint32 countCapacity;
+		K * scratchKeys;
+		V * scratchValues;
+		uint64 * counts;
+
+		static uint32 digit(K key, uint32 pass) {
+			return (uint32) (key >> (pass * 8)) & (DIGITS - 1);
+		}
+
+		void reserveCounts(uint32 numBlocks) {
+			if (countCapacity < numBlocks) {
+				delete [] counts;
+				countCapacity = numBlocks;
+				counts = new uint64[(uint64) numBlocks * DIGITS];
+			}
+		}
+
+		void sortSerial(uint64 num, K * keys, V * values) {
+			reserveCounts(PASSES);
+			memset(counts, 0, sizeof(uint64) * PASSES * DIGITS);
+			for (uint64 i = 0; i < num; ++i)
+				for (uint32 pass = 0; pass < PASSES; ++pass)
+					++counts[pass * DIGITS + digit(keys[i], pass)];
+
+			K * sourceKeys = keys;
+			V * sourceValues = values;
+			K * targetKeys = scratchKeys;
+			V * targetValues = scratchValues;
+			for (uint32 pass = 0; pass < PASSES; ++pass) {
+				uint64 * offsets = counts + pass * DIGITS;
+				if (offsets[digit(sourceKeys[0], pass)] == num)
+					continue;
+				uint64 offset = 0;
+				for (uint32 i = 0; i < DIGITS; ++i) {
+					uint64 count = offsets[i];
+					offsets[i] = offset;
+					offset += count;
+				}
+				for (uint64 i = 0; i < num; ++i) {
+					uint64 index = offsets[digit(sourceKeys[i], pass)]++;
+					targetKeys[index] = sourceKeys[i];
+					if (values)
+						targetValues[index] = sourceValues[i];
+				}
+				std::swap(sourceKeys, targetKeys);
+				std::swap(sourceValues, targetValues);
+			}
+			finish(num, keys, values, sourceKeys, sourceValues);
+		}
+
+		void sortParallel(uint64 num, K * keys, V * values, GenoThreadPool * pool) {
+			uint64 numBlocks = pool->getThreadCount() + 1;
+			if (numBlocks > num / GENO_RADIX_SORT_MIN_BLOCK)
+				numBlocks = num / GENO_RADIX_SORT_MIN_BLOCK;
+			uint64 blockLength = (num + numBlocks - 1) / numBlocks;
+			reserveCounts((uint32) numBlocks);
+
+			K * sourceKeys = keys;
+			V * sourceValues = values;
+			K * targetKeys = scratchKeys;
+			V * targetValues = scratchValues;
+			uint64 * blockCounts = counts;
+			for (uint32 pass = 0; pass < PASSES; ++pass) {
+				pool->parallelFor(0, numBlocks, [=](uint64 block) {
+					uint64 * blockOffsets = blockCounts + block * DIGITS;
+					memset(blockOffsets, 0, sizeof(uint64) * DIGITS);
+					uint64 end = (block + 1) * blockLength < num ? (block + 1) * blockLength : num;
+					for (uint64 i = block * blockLength; i < end; ++i)
+						++blockOffsets[digit(sourceKeys[i], pass)];
+				}, 1);
+
+				// Each block scatters into the slots after every lower digit and every earlier block's keys of its digit
+				uint64 offset = 0;
+				bool skip = false;
+				for (uint32 i = 0; i < DIGITS && !skip; ++i) {
+					uint64 start = offset;
+					for (uint64 block = 0; block < numBlocks; ++block) {
+						uint64 count = blockCounts[block * DIGITS + i];
+						blockCounts[block * DIGITS + i] = offset;
+						offset += count;
+					}
+					skip = offset - start == num;
+				}
+				if (skip)
+					continue;
+
+				pool->parallelFor(0, numBlocks, [=](uint64 block) {
+					uint64 * blockOffsets = blockCounts + block * DIGITS;
+					uint64 end = (block + 1) * blockLength < num ? (block + 1) * blockLength : num;
+					for (uint64 i = block * blockLength; i < end; ++i) {
+						uint64 index = blockOffsets[digit(sourceKeys[i], pass)]++;
+						targetKeys[index] = sourceKeys[i];
+						if (values)
+							targetValues[index] = sourceValues[i];
+					}
+				}, 1);
+				std::swap(sourceKeys, targetKeys);
+				std::swap(sourceValues, targetValues);
+			}
+			finish(num, keys, values, sourceKeys, sourceValues);
+		}
+
+		void finish(uint64 num, K * keys, V * values, K * sortedKeys, V * sortedValues) {
+			// An odd number of passes leaves the result in the scratch buffers
+			if (sortedKeys != keys) {
+				memcpy(keys, sortedKeys, sizeof(K) * num);
+				if (values)
+					for (uint64 i = 0; i < num; ++i)
+						values[i] = sortedValues[i];
+			}
+		}
+
+	public:
+		/**
+		 * @param capacity - The number of keys to make room for up front
+		 * @param withValues - Whether to make room for payloads too
+		**/
+		GenoRadixSorter(uint64 capacity = 0, bool withValues = false) :
+			keyCapacity(0),
+			valueCapacity(0),
+			countCapacity(0),
+			scratchKeys(0),
+			scratchValues(0),
+			counts(0) {
+			reserve(capacity, withValues);
+		}
+
+		GenoRadixSorter(const GenoRadixSorter<K, V> & sorter) = delete;
+		GenoRadixSorter<K, V> & operator=(const GenoRadixSorter<K, V> & sorter) = delete;
+
+		/**
+		 * Grows the scratch buffers to fit a number of keys ahead of time
+		 *
+		 * @param capacity - The number of keys
+		 * @param withValues - Whether to make room for payloads too
+		**/
+		void reserve(uint64 capacity, bool withValues) {
+			if (keyCapacity < capacity) {
+				delete [] scratchKeys;
+				keyCapacity = capacity;
+				scratchKeys = new K[capacity];
+			}
+			if (withValues && valueCapacity < capacity) {
+				delete [] scratchValues;
+				valueCapacity = capacity;
+				scratchValues = new V[capacity];
+			}
+		}
+
+		/**
+		 * Sorts keys in ascending order, moving each payload along with its key
+		 *
+		 * @param num - The number of keys
+		 * @param keys - The keys
+		 * @param values - The payloads, can be null
+		 * @param pool - The thread pool to split large sorts across, can be null
+		**/
+		void sort(uint64 num, K keys[], V values[] = 0, GenoThreadPool * pool = 0) {
+			if (num < 2)
+				return;
+			reserve(num, values != 0);
+			if (pool && pool->getThreadCount() > 0 && num >= GENO_RADIX_SORT_PARALLEL_THRESHOLD)
+				sortParallel(num, keys, values, pool);
+			else
+				sortSerial(num, keys, values);
+		}
+
+		/**
+		 * Sorts a list of keys in ascending order
+		**/
+		template <typename S>
+		void sort(GenoArrayList<K, S> & keys, GenoThreadPool * pool = 0) {
+			if (keys.getLength() > 0)
+				sort(keys.getLength(), &keys[0], 0, pool);
+		}
+
+		/**
+		 * Sorts a list of keys in ascending order along with a list of as many payloads
+		**/
+		template <typename S>
+		void sort(GenoArrayList<K, S> & keys, GenoArrayList<V, S> & values, GenoThreadPool * pool = 0) {
+			if (keys.getLength() > 0)
+				sort(keys.getLength(), &keys[0], &values[0], pool);
+		}
+
+		~GenoRadixSorter() {
+			delete [] scratchKeys;
+			delete [] scratchValues;
+			delete [] counts;
+		}
+};
+
+#define GNARLY_GENOME_RADIX_SORT_FORWARD
+#endif // GNARLY_GENOME_RADIX_SORT
\ No newline at end of file
@@ -0,0 +1,186 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_RING_BUFFER
+#define GNARLY_GENOME_RING_BUFFER
+
+#include <atomic>
+#include <utility>
+
+#include "../GenoInts.h"
+
+/**
+ * A contiguous run of elements inside a GenoRingBuffer
+**/
+template <typename T>
+struct GenoRingSpan {
+	T * elements;
+	uint32 length;
+};
+
+/**
+ * A wait free single producer single consumer ring buffer
+ *
+ * One thread produces and one thread consumes. Each side keeps a cached copy of the other side's
+ * index and only reloads it when the cache says the buffer is full or empty, so the shared
+ * indices are rarely touched. The producer can write elements in place with reserve and commit
+ * and the consumer can read them in place with peek and release. The capacity is rounded up to
+ * a power of two and never grows.
+**/
+template <typename T>
+class GenoRingBuffer {
+	private:
+		uint64 mask;
+		T * array;
+
+		alignas(64) std::atomic<uint64> tail;
+		uint64 cachedHead;
+
+		alignas(64) std::atomic<uint64> head;
+		uint64 cachedTail;
+
+	public:
+		GenoRingBuffer(uint32 capacity = 1024) :
+			tail(0),
+			cachedHead(0),
+			head(0),
+			cachedTail(0) {
+			uint64 powerOfTwo = 2;
+			while (powerOfTwo < capacity)
+				powerOfTwo <<= 1;
+			mask  = powerOfTwo - 1;
+			array = new T[powerOfTwo];
+		}
+
+		GenoRingBuffer(const GenoRingBuffer<T> & buffer) = delete;
+		GenoRingBuffer<T> & operator=(const GenoRingBuffer<T> & buffer) = delete;
+
+		/**
+		 * Reserves contiguous room to write up to count elements in place, only the producer may reserve
+		 *
+		 * The span stops at the end of the underlying array, so it can be shorter than the free space.
+		 * Reserve again after committing to continue past the wrap.
+		 *
+		 * @param count - The most elements wanted
+		 *
+		 * @return - The reserved slots, empty when the buffer is full
+		**/
+		GenoRingSpan<T> reserve(uint32 count) {
+			uint64 t = tail.load(std::memory_order_relaxed);
+			uint64 capacity = mask + 1;
+			if (t - cachedHead + count > capacity)
+				cachedHead = head.load(std::memory_order_acquire);
+			uint64 free = capacity - (t - cachedHead);
+			uint64 contiguous = capacity - (t & mask);
+			uint64 length = count < free ? count : free;
+			if (length > contiguous)
+				length = contiguous;
+			return { array + (t & mask), (uint32) length };
+		}
+
+		/**
+		 * Publishes the first count reserved elements to the consumer
+		**/
+		void commit(uint32 count) {
+			tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+		}
+
+		/**
+		 * Pushes an element, only the producer may push
+		 *
+		 * @return - Whether there was room for the element
+		**/
+		bool tryPush(const T & element) {
+			GenoRingSpan<T> span = reserve(1);
+			if (span.length == 0)
+				return false;
+			*span.elements = element;
+			commit(1);
+			return true;
+		}
+
+		/**
+		 * Returns the contiguous run of up to count readable elements, only the consumer may peek
+		 *
+		 * Like reserve, the span stops at the end of the underlying array.
+		 *
+		 * @param count - The most elements wanted
+		 *
+		 * @return - The readable elements, empty when the buffer is empty
+		**/
+		GenoRingSpan<T> peek(uint32 count) {
+			uint64 h = head.load(std::memory_order_relaxed);
+			if (cachedTail - h < count)
+				cachedTail = tail.load(std::memory_order_acquire);
+			uint64 available = cachedTail - h;
+			uint64 contiguous = mask + 1 - (h & mask);
+			uint64 length = count < available ? count : available;
+			if (length > contiguous)
+				length = contiguous;
+			return { array + (h & mask), (uint32) length };
+		}
+
+		/**
+		 * Hands the first count peeked slots back to the producer
+		**/
+		void release(uint32 count) {
+			head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+		}
+
+		/**
+		 * Pops the oldest element, only the consumer may pop
+		 *
+		 * @return - Whether there was an element to pop
+		**/
+		bool tryPop(T & element) {
+			GenoRingSpan<T> span = peek(1);
+			if (span.length == 0)
+				return false;
+			element = std::move(*span.elements);
+			release(1);
+			return true;
+		}
+
+		/**
+		 * Returns an estimate of the number of elements in the buffer
+		**/
+		uint64 getLength() const {
+			uint64 h = head.load(std::memory_order_relaxed);
+			uint64 t = tail.load(std::memory_order_relaxed);
+			return t > h ? t - h : 0;
+		}
+
+		uint64 getCapacity() const {
+			return mask + 1;
+		}
+
+		~GenoRingBuffer() {
+			delete [] array;
+		}
+};
+
+#define GNARLY_GENOME_RING_BUFFER_FORWARD
+#endif // GNARLY_GENOME_RING_BUFFER
\ No newline at end of file
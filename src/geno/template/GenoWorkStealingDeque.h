@@ -0,0 +1,207 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_WORK_STEALING_DEQUE
+#define GNARLY_GENOME_WORK_STEALING_DEQUE
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+#include "../GenoInts.h"
+
+/**
+ * A Chase-Lev work stealing deque
+ *
+ * The owning thread pushes and pops at the bottom, any other thread may steal from the top.
+ * Elements are copied through relaxed atomic words, so a thief that reads a slot while the
+ * owner overwrites it simply loses its compare and swap on top and discards the copy.
+**/
+template <typename T>
+class GenoWorkStealingDeque {
+	private:
+		static_assert(std::is_trivially_copyable<T>::value, "GenoWorkStealingDeque elements must be trivially copyable!");
+
+		constexpr static uint32 WORDS = (sizeof(T) + sizeof(uint64) - 1) / sizeof(uint64);
+
+		struct GenoWorkStealingSlot {
+			std::atomic<uint64> words[WORDS];
+		};
+
+		struct GenoWorkStealingArray {
+			int64 mask;
+			GenoWorkStealingSlot * slots;
+			GenoWorkStealingArray * retired;
+
+			GenoWorkStealingArray(int64 capacity, GenoWorkStealingArray * retired) :
+				mask(capacity - 1),
+				slots(new GenoWorkStealingSlot[capacity]),
+				retired(retired) {}
+
+			void put(int64 index, const T & element) {
+				uint64 words[WORDS] = {};
+				memcpy(words, &element, sizeof(T));
+				GenoWorkStealingSlot & slot = slots[index & mask];
+				for (uint32 i = 0; i < WORDS; ++i)
+					slot.words[i].store(words[i], std::memory_order_relaxed);
+			}
+
+			T get(int64 index) const {
+				uint64 words[WORDS];
+				const GenoWorkStealingSlot & slot = slots[index & mask];
+				for (uint32 i = 0; i < WORDS; ++i)
+					words[i] = slot.words[i].load(std::memory_order_relaxed);
+				T ret;
+				memcpy(&ret, words, sizeof(T));
+				return ret;
+			}
+
+			~GenoWorkStealingArray() {
+				delete [] slots;
+			}
+		};
+
+		alignas(64) std::atomic<int64> top;
+		alignas(64) std::atomic<int64> bottom;
+		std::atomic<GenoWorkStealingArray *> array;
+
+		GenoWorkStealingArray * grow(GenoWorkStealingArray * old, int64 top, int64 bottom, int64 capacity) {
+			// Thieves may still be reading the old array so it is kept until the deque is destroyed
+			auto newArray = new GenoWorkStealingArray(capacity, old);
+			for (int64 i = top; i < bottom; ++i)
+				newArray->put(i, old->get(i));
+			array.store(newArray, std::memory_order_release);
+			return newArray;
+		}
+
+	public:
+		GenoWorkStealingDeque(uint32 capacity = 64) :
+			top(0),
+			bottom(0) {
+			int64 powerOfTwo = 2;
+			while (powerOfTwo < capacity)
+				powerOfTwo <<= 1;
+			array.store(new GenoWorkStealingArray(powerOfTwo, 0), std::memory_order_relaxed);
+		}
+
+		GenoWorkStealingDeque(const GenoWorkStealingDeque<T> & deque) = delete;
+		GenoWorkStealingDeque<T> & operator=(const GenoWorkStealingDeque<T> & deque) = delete;
+
+		/**
+		 * Pushes an element onto the bottom of the deque, only the owner may push
+		**/
+		void push(const T & element) {
+			int64 b = bottom.load(std::memory_order_relaxed);
+			int64 t = top.load(std::memory_order_acquire);
+			GenoWorkStealingArray * a = array.load(std::memory_order_relaxed);
+			if (b - t > a->mask)
+				a = grow(a, t, b, (a->mask + 1) << 1);
+			a->put(b, element);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Makes room for count more elements so they can be pushed without growing, only the owner may reserve
+		**/
+		void reserve(uint32 count) {
+			int64 b = bottom.load(std::memory_order_relaxed);
+			int64 t = top.load(std::memory_order_acquire);
+			GenoWorkStealingArray * a = array.load(std::memory_order_relaxed);
+			int64 needed = b - t + count;
+			if (needed > a->mask + 1) {
+				int64 capacity = (a->mask + 1) << 1;
+				while (capacity < needed)
+					capacity <<= 1;
+				grow(a, t, b, capacity);
+			}
+		}
+
+		/**
+		 * Pops the most recently pushed element, only the owner may pop
+		 *
+		 * @return - Whether an element was popped
+		**/
+		bool pop(T & element) {
+			int64 b = bottom.load(std::memory_order_relaxed) - 1;
+			GenoWorkStealingArray * a = array.load(std::memory_order_relaxed);
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64 t = top.load(std::memory_order_relaxed);
+			if (t > b) {
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+			element = a->get(b);
+			if (t == b) {
+				// Last element, race any thieves for it
+				bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
+			return true;
+		}
+
+		/**
+		 * Steals the least recently pushed element, any thread may steal
+		 *
+		 * @return - Whether an element was stolen. Fails spuriously when another thread wins the element
+		**/
+		bool steal(T & element) {
+			int64 t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64 b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+				return false;
+			GenoWorkStealingArray * a = array.load(std::memory_order_acquire);
+			T stolen = a->get(t);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return false;
+			element = stolen;
+			return true;
+		}
+
+		/**
+		 * Returns an estimate of the number of elements in the deque
+		**/
+		int64 getLength() const {
+			int64 b = bottom.load(std::memory_order_relaxed);
+			int64 t = top.load(std::memory_order_relaxed);
+			return b > t ? b - t : 0;
+		}
+
+		~GenoWorkStealingDeque() {
+			GenoWorkStealingArray * a = array.load(std::memory_order_relaxed);
+			while (a != 0) {
+				GenoWorkStealingArray * retired = a->retired;
+				delete a;
+				a = retired;
+			}
+		}
+};
+
+#define GNARLY_GENOME_WORK_STEALING_DEQUE_FORWARD
+#endif // GNARLY_GENOME_WORK_STEALING_DEQUE
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include <cstdio>
+
+#include "GenoCoroutine.h"
+
+GenoAwaitFileRead::GenoAwaitFileRead(GenoThreadPool * pool, const char * path) :
+	pool(pool),
+	path(path),
+	file({ 0, 0 }) {}
+
+void GenoAwaitFileRead::readJob(GenoThreadPoolJobData data) {
+	GenoAwaitFileRead * awaiter = (GenoAwaitFileRead *) data;
+	FILE * fp = fopen(awaiter->path, "rb");
+	if (fp != 0) {
+		if (fseek(fp, 0, SEEK_END) == 0) {
+			long length = ftell(fp);
+			if (length >= 0 && fseek(fp, 0, SEEK_SET) == 0) {
+				awaiter->file.bytes  = new uint8[length > 0 ? length : 1];
+				awaiter->file.length = fread(awaiter->file.bytes, 1, length, fp);
+				if (awaiter->file.length != (uint64) length) {
+					delete [] awaiter->file.bytes;
+					awaiter->file.bytes  = 0;
+					awaiter->file.length = 0;
+				}
+			}
+		}
+		fclose(fp);
+	}
+	awaiter->handle.resume();
+}
+
+bool GenoAwaitFileRead::await_ready() const noexcept {
+	return false;
+}
+
+void GenoAwaitFileRead::await_suspend(std::coroutine_handle<> handle) {
+	this->handle = handle;
+	pool->submitJob(readJob, this);
+}
+
+GenoFileBuffer GenoAwaitFileRead::await_resume() noexcept {
+	return file;
+}
\ No newline at end of file
@@ -0,0 +1,387 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_COROUTINE_FORWARD
+#define GNARLY_GENOME_COROUTINE_FORWARD
+
+template <typename T>
+class GenoCoroutineTask;
+
+class GenoResumeOnPool;
+class GenoResumeOnQueue;
+class GenoAwaitCounter;
+class GenoAwaitFileRead;
+
+#endif // GNARLY_GENOME_COROUTINE_FORWARD
+
+#ifndef GNARLY_GENOME_COROUTINE
+#define GNARLY_GENOME_COROUTINE
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <exception>
+#include <coroutine>
+#include <type_traits>
+
+#include "../GenoInts.h"
+#include "GenoThreadPool.h"
+#include "GenoDispatchQueue.h"
+
+/**
+ * Coroutine support for GenoThreadPool, requires C++20
+ *
+ * A coroutine returning GenoCoroutineTask<T> can co_await pool work. It suspends without holding a
+ * thread and is resumed on the pool worker that finished the work it was waiting on, or on the thread
+ * draining a dispatch queue for work that has to happen there:
+ *
+ *     GenoCoroutineTask<GenoTexture *> loadTexture(GenoThreadPool * pool, const char * path) {
+ *         GenoFileBuffer file = co_await GenoAwaitFileRead(pool, path);
+ *         GenoImage * image = co_await GenoAwaitJob(pool, [&file] { return decode(file); });
+ *         co_await GenoResumeOnQueue(GenoEngine::getMainQueue());
+ *         ...
+ *     }
+**/
+
+/**
+ * The result of GenoAwaitFileRead, bytes is null if the file could not be read and must be deleted with delete []
+**/
+struct GenoFileBuffer {
+	uint8 * bytes;
+	uint64 length;
+};
+
+/**
+ * Suspends the coroutine and resumes it on a pool worker
+**/
+class GenoResumeOnPool {
+	private:
+		GenoThreadPool * pool;
+	public:
+		GenoResumeOnPool(GenoThreadPool * pool) :
+			pool(pool) {}
+
+		static void resumeJob(GenoThreadPoolJobData data) {
+			std::coroutine_handle<>::from_address(data).resume();
+		}
+
+		bool await_ready() const noexcept {
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) {
+			pool->submitJob(resumeJob, handle.address());
+		}
+
+		void await_resume() noexcept {}
+};
+
+/**
+ * Suspends the coroutine and resumes it on the thread that drains a dispatch queue
+ *
+ * Used to move the end of a chain of pool work onto the thread that owns a resource, such as the
+ * main thread for GL uploads. The coroutine resumes during the next drain of the queue.
+**/
+class GenoResumeOnQueue {
+	private:
+		GenoDispatchQueue * queue;
+	public:
+		GenoResumeOnQueue(GenoDispatchQueue * queue) :
+			queue(queue) {}
+
+		bool await_ready() const noexcept {
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) {
+			queue->post(GenoResumeOnPool::resumeJob, handle.address());
+		}
+
+		void await_resume() noexcept {}
+};
+
+template <typename T>
+class GenoCoroutinePromiseResult {
+	private:
+		T result;
+	public:
+		void return_value(T value) {
+			result = std::move(value);
+		}
+
+		T & getResult() {
+			return result;
+		}
+};
+
+template <>
+class GenoCoroutinePromiseResult<void> {
+	public:
+		void return_void() {}
+		void getResult() {}
+};
+
+/**
+ * A coroutine that runs on a GenoThreadPool
+ *
+ * Tasks start suspended. Either start one on a pool or co_await it from another task, which runs it
+ * on the awaiting thread and resumes the awaiting task once it finishes. The task owns the coroutine
+ * and must outlive it. T must be default constructible.
+ *
+ * Completion is signalled through a job counter, so a thread waiting on a task helps with queued jobs
+ * and then sleeps like GenoThreadPool::wait(counter).
+**/
+template <typename T = void>
+class GenoCoroutineTask {
+	public:
+		class promise_type : public GenoCoroutinePromiseResult<T> {
+			private:
+				std::coroutine_handle<> continuation;
+				std::atomic<GenoThreadPool *> pool;
+				GenoJobCounter done;
+			public:
+				promise_type() :
+					pool(0) {
+					done.count.store(1, std::memory_order_relaxed);
+				}
+
+				GenoCoroutineTask<T> get_return_object() {
+					return GenoCoroutineTask<T>(std::coroutine_handle<promise_type>::from_promise(*this));
+				}
+
+				std::suspend_always initial_suspend() noexcept {
+					return {};
+				}
+
+				auto final_suspend() noexcept {
+					struct GenoFinalAwaiter {
+						bool await_ready() noexcept {
+							return false;
+						}
+
+						std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+							promise_type & promise = handle.promise();
+							std::coroutine_handle<> continuation = promise.continuation;
+							// The owner may destroy the coroutine as soon as it sees done
+							finish(promise);
+							return continuation ? continuation : std::noop_coroutine();
+						}
+
+						void await_resume() noexcept {}
+					};
+					return GenoFinalAwaiter();
+				}
+
+				void unhandled_exception() {
+					std::terminate();
+				}
+
+			friend class GenoCoroutineTask<T>;
+		};
+
+	private:
+		std::coroutine_handle<promise_type> handle;
+
+		GenoCoroutineTask(std::coroutine_handle<promise_type> handle) :
+			handle(handle) {}
+
+		/**
+		 * Stands in for the pool once a task has finished without one to wake, it is never dereferenced
+		**/
+		static GenoThreadPool * finishedMarker() {
+			static char marker;
+			return (GenoThreadPool *) &marker;
+		}
+
+		static void finish(promise_type & promise) {
+			// Claiming the pool slot first means a waiter either registered its pool in time to be woken or sees the marker
+			GenoThreadPool * pool = 0;
+			if (promise.pool.compare_exchange_strong(pool, finishedMarker()))
+				promise.done.count.store(0, std::memory_order_release);
+			else
+				pool->finishCounted(promise.done);
+		}
+	public:
+		GenoCoroutineTask(const GenoCoroutineTask<T> & task) = delete;
+
+		GenoCoroutineTask(GenoCoroutineTask<T> && task) noexcept :
+			handle(task.handle) {
+			task.handle = 0;
+		}
+
+		/**
+		 * Starts the task on a pool worker
+		**/
+		void start(GenoThreadPool * pool) {
+			handle.promise().pool.store(pool, std::memory_order_relaxed);
+			pool->submitJob(GenoResumeOnPool::resumeJob, handle.address());
+		}
+
+		/**
+		 * Returns whether the task has returned
+		**/
+		bool isDone() const {
+			return handle.promise().done.isDone();
+		}
+
+		/**
+		 * Blocks until the task has returned, running queued jobs on the calling thread in the meantime
+		 *
+		 * @param pool - The pool to help, a task started on a pool always waits on that one
+		**/
+		void wait(GenoThreadPool * pool) {
+			promise_type & promise = handle.promise();
+			GenoThreadPool * owner = 0;
+			if (promise.pool.compare_exchange_strong(owner, pool))
+				owner = pool;
+			if (owner == finishedMarker()) {
+				// The task is past its last suspension and only has to release the counter
+				while (!isDone())
+					std::this_thread::yield();
+				return;
+			}
+			owner->wait(promise.done);
+		}
+
+		/**
+		 * Returns the task's result, only valid once the task is done
+		**/
+		decltype(auto) getResult() {
+			return handle.promise().getResult();
+		}
+
+		bool await_ready() const noexcept {
+			return false;
+		}
+
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+			handle.promise().continuation = awaiting;
+			return handle;
+		}
+
+		decltype(auto) await_resume() {
+			return handle.promise().getResult();
+		}
+
+		~GenoCoroutineTask() {
+			if (handle)
+				handle.destroy();
+		}
+};
+
+/**
+ * Runs a callable on the pool and resumes the coroutine with its result on the same worker
+ *
+ * The callable is only referenced, it lives in the suspended coroutine's frame until it has run
+**/
+template <typename F>
+class GenoAwaitJob {
+	private:
+		typedef decltype(std::declval<F &>()()) R;
+
+		GenoThreadPool * pool;
+		F func;
+		typename std::conditional<std::is_void<R>::value, char, R>::type result;
+	public:
+		GenoAwaitJob(GenoThreadPool * pool, F func) :
+			pool(pool),
+			func(std::move(func)) {}
+
+		bool await_ready() const noexcept {
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) {
+			GenoAwaitJob<F> * awaiter = this;
+			void * address = handle.address();
+			pool->submitJob([awaiter, address] {
+				if constexpr (std::is_void<R>::value)
+					awaiter->func();
+				else
+					awaiter->result = awaiter->func();
+				std::coroutine_handle<>::from_address(address).resume();
+			});
+		}
+
+		R await_resume() {
+			if constexpr (!std::is_void<R>::value)
+				return std::move(result);
+		}
+};
+
+/**
+ * Resumes the coroutine on a pool worker once every job counted by a counter has finished
+ *
+ * Only one coroutine may wait on a counter at a time
+**/
+class GenoAwaitCounter {
+	private:
+		GenoThreadPool * pool;
+		GenoJobCounter * counter;
+	public:
+		GenoAwaitCounter(GenoThreadPool * pool, GenoJobCounter & counter) :
+			pool(pool),
+			counter(&counter) {}
+
+		bool await_ready() const noexcept {
+			return counter->isDone();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) {
+			pool->submitJobAfter(*counter, GenoResumeOnPool::resumeJob, handle.address());
+		}
+
+		void await_resume() noexcept {}
+};
+
+/**
+ * Reads a whole file on a pool worker and resumes the coroutine with its contents on the same worker
+ *
+ * The read itself blocks the worker it runs on, the coroutine does not hold any thread while it waits
+**/
+class GenoAwaitFileRead {
+	private:
+		GenoThreadPool * pool;
+		const char * path;
+		GenoFileBuffer file;
+		std::coroutine_handle<> handle;
+
+		static void readJob(GenoThreadPoolJobData data);
+	public:
+
+		/**
+		 * @param pool - The pool to read the file on
+		 * @param path - The path of the file, it must stay valid until the coroutine resumes
+		**/
+		GenoAwaitFileRead(GenoThreadPool * pool, const char * path);
+
+		bool await_ready() const noexcept;
+		void await_suspend(std::coroutine_handle<> handle);
+		GenoFileBuffer await_resume() noexcept;
+};
+
+#define GNARLY_GENOME_COROUTINE_FORWARD
+#endif // GNARLY_GENOME_COROUTINE
\ No newline at end of file
@@ -0,0 +1,371 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include <thread>
+#include <cstdio>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+#endif
+
+#include "../template/GenoArrayList.h"
+
+#include "GenoCpuTopology.h"
+
+namespace {
+	/**
+	 * Sparse keys read from the system before they are renumbered
+	**/
+	struct GenoCpuKeys {
+		uint32 id;
+		uint64 core;
+		uint64 cacheDomain;
+		uint64 numaNode;
+		uint64 package;
+	};
+
+	struct GenoTopology {
+		GenoArrayList<GenoLogicalCpu> cpus;
+		uint32 numCores;
+		uint32 numCacheDomains;
+		uint32 numNumaNodes;
+		uint32 numPackages;
+	};
+
+	uint32 densify(GenoArrayList<uint64> & seen, uint64 key) {
+		for (uint32 i = 0; i < seen.getLength(); ++i)
+			if (seen[i] == key)
+				return i;
+		seen.add(key);
+		return seen.getLength() - 1;
+	}
+
+	#ifdef _WIN32
+
+	void readKeys(GenoArrayList<GenoCpuKeys> & keys) {
+		DWORD length = 0;
+		GetLogicalProcessorInformationEx(RelationAll, 0, &length);
+		if (length == 0)
+			return;
+		uint8 * buffer = new uint8[length];
+		if (GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) buffer, &length)) {
+			// The first pass finds every cpu through the core records, the second assigns the domains
+			uint64 numCores = 0;
+			for (DWORD offset = 0; offset < length;) {
+				auto info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) (buffer + offset);
+				if (info->Relationship == RelationProcessorCore) {
+					for (WORD i = 0; i < info->Processor.GroupCount; ++i)
+						for (uint32 j = 0; j < 64; ++j)
+							if (info->Processor.GroupMask[i].Mask & (((KAFFINITY) 1) << j)) {
+								GenoCpuKeys cpu = { info->Processor.GroupMask[i].Group * 64u + j, numCores, 0, 0, 0 };
+								keys.add(cpu);
+							}
+					++numCores;
+				}
+				offset += info->Size;
+			}
+			uint64 numCaches = 0;
+			uint64 numPackages = 0;
+			for (DWORD offset = 0; offset < length;) {
+				auto info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) (buffer + offset);
+				const GROUP_AFFINITY * masks = 0;
+				WORD numMasks = 0;
+				uint64 GenoCpuKeys::* field = 0;
+				uint64 value = 0;
+				if (info->Relationship == RelationCache && info->Cache.Level == 3) {
+					masks    = &info->Cache.GroupMask;
+					numMasks = 1;
+					field    = &GenoCpuKeys::cacheDomain;
+					value    = numCaches++;
+				}
+				else if (info->Relationship == RelationNumaNode) {
+					masks    = &info->NumaNode.GroupMask;
+					numMasks = 1;
+					field    = &GenoCpuKeys::numaNode;
+					value    = info->NumaNode.NodeNumber;
+				}
+				else if (info->Relationship == RelationProcessorPackage) {
+					masks    = info->Processor.GroupMask;
+					numMasks = info->Processor.GroupCount;
+					field    = &GenoCpuKeys::package;
+					value    = numPackages++;
+				}
+				for (WORD i = 0; i < numMasks; ++i)
+					for (uint32 j = 0; j < keys.getLength(); ++j)
+						if (masks[i].Group == keys[j].id / 64 && (masks[i].Mask & (((KAFFINITY) 1) << (keys[j].id % 64))))
+							keys[j].*field = value;
+				offset += info->Size;
+			}
+		}
+		delete [] buffer;
+	}
+
+	#else
+
+	bool readUint(const char * path, uint64 & value) {
+		FILE * fp = fopen(path, "r");
+		if (fp == 0)
+			return false;
+		unsigned long long read = 0;
+		bool success = fscanf(fp, "%llu", &read) == 1;
+		fclose(fp);
+		value = read;
+		return success;
+	}
+
+	/**
+	 * Parses a sysfs cpu list such as "0-3,8,10-11", calling add for every cpu in it
+	**/
+	template <typename F>
+	bool readCpuList(const char * path, F add) {
+		FILE * fp = fopen(path, "r");
+		if (fp == 0)
+			return false;
+		unsigned int first = 0;
+		unsigned int last = 0;
+		bool success = false;
+		while (fscanf(fp, "%u", &first) == 1) {
+			last = first;
+			int separator = fgetc(fp);
+			if (separator == '-') {
+				if (fscanf(fp, "%u", &last) != 1)
+					break;
+				separator = fgetc(fp);
+			}
+			for (uint32 i = first; i <= last; ++i)
+				add(i);
+			success = true;
+			if (separator != ',')
+				break;
+		}
+		fclose(fp);
+		return success;
+	}
+
+	/**
+	 * Reads the cpus the process may run on, growing the mask until the kernel's fits. Returns null if it cannot be read
+	**/
+	cpu_set_t * readAffinity(size_t & size) {
+		for (uint32 numIds = 1024; numIds <= 0x100000; numIds *= 2) {
+			cpu_set_t * set = CPU_ALLOC(numIds);
+			if (set == 0)
+				return 0;
+			size = CPU_ALLOC_SIZE(numIds);
+			if (sched_getaffinity(0, size, set) == 0)
+				return set;
+			CPU_FREE(set);
+			if (errno != EINVAL)
+				return 0;
+		}
+		return 0;
+	}
+
+	void readKeys(GenoArrayList<GenoCpuKeys> & keys) {
+		char path[128];
+		// Cpus outside the affinity mask, such as those outside a container's cpuset, cannot be used so are left out
+		size_t affinitySize = 0;
+		cpu_set_t * affinity = readAffinity(affinitySize);
+		readCpuList("/sys/devices/system/cpu/online", [&keys, affinity, affinitySize](uint32 id) {
+			if (affinity != 0 && (id >= affinitySize * 8 || !CPU_ISSET_S(id, affinitySize, affinity)))
+				return;
+			GenoCpuKeys cpu = { id, id, 0, 0, 0 };
+			keys.add(cpu);
+		});
+		if (affinity != 0)
+			CPU_FREE(affinity);
+		for (uint32 i = 0; i < keys.getLength(); ++i) {
+			GenoCpuKeys & cpu = keys[i];
+			uint64 coreId = cpu.id;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu.id);
+			readUint(path, cpu.package);
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/core_id", cpu.id);
+			readUint(path, coreId);
+			// Core ids are only unique within a package
+			cpu.core = (cpu.package << 32) | coreId;
+
+			// The highest cache level is the last level cache, it is named after the lowest cpu sharing it
+			uint64 highestLevel = 0;
+			for (uint32 j = 0; j < 16; ++j) {
+				uint64 level = 0;
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", cpu.id, j);
+				if (!readUint(path, level))
+					break;
+				if (level >= highestLevel) {
+					uint64 lowest = ~((uint64) 0);
+					snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", cpu.id, j);
+					if (readCpuList(path, [&lowest](uint32 id) { lowest = id < lowest ? id : lowest; })) {
+						highestLevel = level;
+						cpu.cacheDomain = lowest;
+					}
+				}
+			}
+
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu.id);
+			DIR * directory = opendir(path);
+			if (directory != 0) {
+				unsigned int node = 0;
+				for (dirent * entry = readdir(directory); entry != 0; entry = readdir(directory))
+					if (sscanf(entry->d_name, "node%u", &node) == 1)
+						cpu.numaNode = node;
+				closedir(directory);
+			}
+		}
+	}
+
+	#endif // _WIN32
+
+	GenoTopology detect() {
+		GenoArrayList<GenoCpuKeys> keys;
+		readKeys(keys);
+		if (keys.getLength() == 0) {
+			uint32 count = std::thread::hardware_concurrency();
+			for (uint32 i = 0; i < (count > 0 ? count : 1); ++i) {
+				GenoCpuKeys cpu = { i, i, 0, 0, 0 };
+				keys.add(cpu);
+			}
+		}
+
+		GenoArrayList<uint64> cores;
+		GenoArrayList<uint64> cacheDomains;
+		GenoArrayList<uint64> numaNodes;
+		GenoArrayList<uint64> packages;
+		GenoTopology ret;
+		for (uint32 i = 0; i < keys.getLength(); ++i) {
+			GenoLogicalCpu cpu;
+			cpu.id          = keys[i].id;
+			cpu.package     = densify(packages,     keys[i].package);
+			cpu.cacheDomain = densify(cacheDomains, keys[i].cacheDomain);
+			cpu.numaNode    = densify(numaNodes,    keys[i].numaNode);
+			cpu.core        = densify(cores,        keys[i].core);
+			cpu.smtIndex    = 0;
+			for (uint32 j = 0; j < ret.cpus.getLength(); ++j)
+				if (ret.cpus[j].core == cpu.core)
+					++cpu.smtIndex;
+			ret.cpus.add(cpu);
+		}
+		std::sort(&ret.cpus[0], &ret.cpus[0] + ret.cpus.getLength(), [](const GenoLogicalCpu & a, const GenoLogicalCpu & b) {
+			if (a.package != b.package)
+				return a.package < b.package;
+			if (a.cacheDomain != b.cacheDomain)
+				return a.cacheDomain < b.cacheDomain;
+			if (a.core != b.core)
+				return a.core < b.core;
+			return a.smtIndex < b.smtIndex;
+		});
+		ret.numCores        = cores.getLength();
+		ret.numCacheDomains = cacheDomains.getLength();
+		ret.numNumaNodes    = numaNodes.getLength();
+		ret.numPackages     = packages.getLength();
+		return ret;
+	}
+
+	const GenoTopology & topology() {
+		static GenoTopology topology = detect();
+		return topology;
+	}
+}
+
+uint32 GenoCpuTopology::getLogicalCpuCount() {
+	return topology().cpus.getLength();
+}
+
+uint32 GenoCpuTopology::getCoreCount() {
+	return topology().numCores;
+}
+
+uint32 GenoCpuTopology::getCacheDomainCount() {
+	return topology().numCacheDomains;
+}
+
+uint32 GenoCpuTopology::getNumaNodeCount() {
+	return topology().numNumaNodes;
+}
+
+uint32 GenoCpuTopology::getPackageCount() {
+	return topology().numPackages;
+}
+
+const GenoLogicalCpu & GenoCpuTopology::getLogicalCpu(uint32 index) {
+	return topology().cpus[index];
+}
+
+uint32 GenoCpuTopology::getCurrentCpu() {
+	#ifdef _WIN32
+		PROCESSOR_NUMBER number;
+		GetCurrentProcessorNumberEx(&number);
+		uint32 id = number.Group * 64u + number.Number;
+	#else
+		int current = sched_getcpu();
+		if (current < 0)
+			return getLogicalCpuCount();
+		uint32 id = current;
+	#endif // _WIN32
+	const GenoTopology & data = topology();
+	for (uint32 i = 0; i < data.cpus.getLength(); ++i)
+		if (data.cpus[i].id == id)
+			return i;
+	return data.cpus.getLength();
+}
+
+bool GenoCpuTopology::pinCurrentThread(uint32 index) {
+	return restrictCurrentThread(1, &index);
+}
+
+bool GenoCpuTopology::restrictCurrentThread(uint32 num, const uint32 indices[]) {
+	if (num == 0)
+		return false;
+	#ifdef _WIN32
+		GROUP_AFFINITY affinity = {};
+		affinity.Group = (WORD) (getLogicalCpu(indices[0]).id / 64);
+		for (uint32 i = 0; i < num; ++i) {
+			uint32 id = getLogicalCpu(indices[i]).id;
+			if (id / 64 == affinity.Group)
+				affinity.Mask |= ((KAFFINITY) 1) << (id % 64);
+		}
+		return SetThreadGroupAffinity(GetCurrentThread(), &affinity, 0) != 0;
+	#else
+		// Sized to the highest id, a fixed cpu_set_t only holds CPU_SETSIZE cpus
+		uint32 numIds = 0;
+		for (uint32 i = 0; i < num; ++i)
+			numIds = std::max(numIds, getLogicalCpu(indices[i]).id + 1);
+		cpu_set_t * set = CPU_ALLOC(numIds);
+		if (set == 0)
+			return false;
+		size_t size = CPU_ALLOC_SIZE(numIds);
+		CPU_ZERO_S(size, set);
+		for (uint32 i = 0; i < num; ++i)
+			CPU_SET_S(getLogicalCpu(indices[i]).id, size, set);
+		bool restricted = pthread_setaffinity_np(pthread_self(), size, set) == 0;
+		CPU_FREE(set);
+		return restricted;
+	#endif // _WIN32
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_CPU_TOPOLOGY
+#define GNARLY_GENOME_CPU_TOPOLOGY
+
+#include "../GenoInts.h"
+
+struct GenoLogicalCpu {
+	/** The operating system's number for the cpu, what affinity masks are built from **/
+	uint32 id;
+	/** The physical core the cpu belongs to **/
+	uint32 core;
+	/** Which SMT sibling of its core the cpu is, 0 for the first **/
+	uint32 smtIndex;
+	/** The last level cache the cpu shares with others, usually the L3 **/
+	uint32 cacheDomain;
+	uint32 numaNode;
+	uint32 package;
+};
+
+/**
+ * The processor topology of the machine, read once from sysfs on Linux and from
+ * GetLogicalProcessorInformationEx on Windows
+ *
+ * Cores, cache domains, NUMA nodes and packages are numbered densely from 0. When the topology
+ * cannot be read every logical cpu is reported as its own core in a single domain. On Linux only the
+ * cpus in the process's affinity mask at first use are included.
+**/
+class GenoCpuTopology final {
+	private:
+		GenoCpuTopology();
+		~GenoCpuTopology();
+	public:
+		static uint32 getLogicalCpuCount();
+		static uint32 getCoreCount();
+		static uint32 getCacheDomainCount();
+		static uint32 getNumaNodeCount();
+		static uint32 getPackageCount();
+
+		/**
+		 * Returns a logical cpu, ordered by package, cache domain, core and SMT sibling
+		 *
+		 * @param index - The index of the cpu, less than getLogicalCpuCount()
+		**/
+		static const GenoLogicalCpu & getLogicalCpu(uint32 index);
+
+		/**
+		 * Returns the index of the logical cpu the calling thread is running on, or getLogicalCpuCount() if unknown
+		**/
+		static uint32 getCurrentCpu();
+
+		/**
+		 * Restricts the calling thread to a single logical cpu
+		 *
+		 * @param index - The index of the cpu
+		 *
+		 * @return - Whether the affinity was set
+		**/
+		static bool pinCurrentThread(uint32 index);
+
+		/**
+		 * Restricts the calling thread to a set of logical cpus
+		 *
+		 * Windows only lets a thread run in one processor group, cpus outside the group of the first are dropped.
+		 *
+		 * @param num - The number of cpus
+		 * @param indices - The indices of the cpus
+		 *
+		 * @return - Whether the affinity was set
+		**/
+		static bool restrictCurrentThread(uint32 num, const uint32 indices[]);
+};
+
+#define GNARLY_GENOME_CPU_TOPOLOGY_FORWARD
+#endif // GNARLY_GENOME_CPU_TOPOLOGY
\ No newline at end of file
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include "GenoTime.h"
+
+#include "GenoDispatchQueue.h"
+
+GenoDispatchQueue::GenoDispatchQueue(uint32 initialCapacity) :
+	jobs(initialCapacity == 0 ? 16 : initialCapacity) {}
+
+void GenoDispatchQueue::invokeRawJob(GenoDispatchPackage & package) {
+	GenoDispatchRawJob * raw = (GenoDispatchRawJob *) package.storage;
+	raw->job(raw->data);
+}
+
+void GenoDispatchQueue::postPackage(const GenoDispatchPackage & package) {
+	std::lock_guard<std::mutex> lock(jobMutex);
+	jobs.enqueue(package);
+}
+
+void GenoDispatchQueue::post(GenoThreadPoolJob job, GenoThreadPoolJobData data) {
+	GenoDispatchPackage package;
+	package.invoke = invokeRawJob;
+	GenoDispatchRawJob raw = { job, data };
+	memcpy(package.storage, &raw, sizeof(raw));
+	postPackage(package);
+}
+
+bool GenoDispatchQueue::drain(double budget) {
+	uint32 remaining;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		remaining = jobs.getLength();
+	}
+	uint64 end = GenoTime::now() + GenoTime::toNanos(budget);
+	while (remaining > 0) {
+		GenoDispatchPackage package;
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			package = jobs.dequeue();
+		}
+		package.invoke(package);
+		--remaining;
+		if (remaining > 0 && GenoTime::now() >= end)
+			return false;
+	}
+	std::lock_guard<std::mutex> lock(jobMutex);
+	return jobs.getLength() == 0;
+}
+
+uint32 GenoDispatchQueue::getLength() {
+	std::lock_guard<std::mutex> lock(jobMutex);
+	return jobs.getLength();
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_DISPATCH_QUEUE
+#define GNARLY_GENOME_DISPATCH_QUEUE
+
+#include <mutex>
+#include <cstring>
+#include <type_traits>
+
+#include "../GenoInts.h"
+#include "../template/GenoQueue.h"
+#include "GenoThreadPool.h"
+
+/**
+ * The number of bytes a dispatch slot holds inline for a callable and its captures
+**/
+#define GENO_DISPATCH_QUEUE_JOB_STORAGE 56
+
+/**
+ * A queue of jobs that any thread may post and one thread runs
+ *
+ * Used to hand work that must happen on a particular thread, such as GL calls on the thread that
+ * owns the context, back from pool jobs. The owning thread drains it within a time budget.
+**/
+class GenoDispatchQueue {
+	private:
+		struct GenoDispatchPackage {
+			void (*invoke)(GenoDispatchPackage & package);
+			alignas(8) unsigned char storage[GENO_DISPATCH_QUEUE_JOB_STORAGE];
+		};
+
+		struct GenoDispatchRawJob {
+			GenoThreadPoolJob job;
+			GenoThreadPoolJobData data;
+		};
+
+		std::mutex jobMutex;
+		GenoQueue<GenoDispatchPackage> jobs;
+
+		static void invokeRawJob(GenoDispatchPackage & package);
+
+		template <typename F>
+		static void invokeJob(GenoDispatchPackage & package) {
+			(*((F *) package.storage))();
+		}
+
+		void postPackage(const GenoDispatchPackage & package);
+
+	public:
+		GenoDispatchQueue(uint32 initialCapacity = 64);
+
+		GenoDispatchQueue(const GenoDispatchQueue & queue) = delete;
+		GenoDispatchQueue & operator=(const GenoDispatchQueue & queue) = delete;
+
+		/**
+		 * Posts a job to be run by the thread draining the queue, any thread may post
+		 *
+		 * @param job - The job to be queued
+		 * @param data - The data for the queued job
+		**/
+		void post(GenoThreadPoolJob job, GenoThreadPoolJobData data = 0);
+
+		/**
+		 * Posts a callable to be run by the thread draining the queue, any thread may post
+		 *
+		 * The callable must be trivially copyable and fit in GENO_DISPATCH_QUEUE_JOB_STORAGE bytes.
+		 *
+		 * @param func - The callable to be queued, called with no arguments
+		**/
+		template <typename F, typename = typename std::enable_if<!std::is_convertible<F, GenoThreadPoolJob>::value>::type>
+		void post(const F & func) {
+			static_assert(std::is_trivially_copyable<F>::value, "GenoDispatchQueue jobs must be trivially copyable, capture by pointer instead!");
+			static_assert(sizeof(F) <= GENO_DISPATCH_QUEUE_JOB_STORAGE, "GenoDispatchQueue job captures exceed GENO_DISPATCH_QUEUE_JOB_STORAGE!");
+			static_assert(alignof(F) <= 8, "GenoDispatchQueue job captures must be at most 8 byte aligned!");
+			GenoDispatchPackage package;
+			package.invoke = invokeJob<F>;
+			memcpy(package.storage, &func, sizeof(F));
+			postPackage(package);
+		}
+
+		/**
+		 * Runs queued jobs in order until the queue is empty or the budget is spent
+		 *
+		 * At least one job runs per call so a slow job cannot stall the queue. Jobs posted while
+		 * draining wait for the next call, and whatever is left over stays queued for it too.
+		 *
+		 * @param budget - The time to spend in milliseconds
+		 *
+		 * @return - Whether the queue was emptied
+		**/
+		bool drain(double budget);
+
+		/**
+		 * Returns the number of queued jobs
+		**/
+		uint32 getLength();
+};
+
+#define GNARLY_GENOME_DISPATCH_QUEUE_FORWARD
+#endif // GNARLY_GENOME_DISPATCH_QUEUE
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include <new>
+#include <cstdint>
+
+#include "GenoScratchAllocator.h"
+
+GenoScratchAllocator::GenoScratchBlock * GenoScratchAllocator::createBlock(uint64 size, GenoScratchBlock * next) {
+	GenoScratchBlock * block = (GenoScratchBlock *) ::operator new(sizeof(GenoScratchBlock) + size);
+	block->next = next;
+	block->size = size;
+	return block;
+}
+
+GenoScratchAllocator::GenoScratchAllocator(uint64 blockSize) :
+	blockSize(blockSize == 0 ? GENO_SCRATCH_ALLOCATOR_BLOCK_SIZE : blockSize),
+	first(0),
+	current(0),
+	offset(0),
+	used(0),
+	highWater(0) {}
+
+void * GenoScratchAllocator::allocate(uint64 size, uint64 align) {
+	if (current == 0) {
+		if (first == 0)
+			first = createBlock(size + align > blockSize ? size + align : blockSize, 0);
+		current = first;
+		offset  = 0;
+	}
+	uintptr_t base  = (uintptr_t) (current + 1);
+	uintptr_t start = (base + offset + align - 1) & ~(uintptr_t) (align - 1);
+	if (start + size > base + current->size) {
+		// Moving on wastes the rest of this block, count it so rewinding stays exact
+		used += current->size - offset;
+		GenoScratchBlock * next = current->next;
+		if (next == 0 || next->size < size + align)
+			next = current->next = createBlock(size + align > blockSize ? size + align : blockSize, next);
+		current = next;
+		offset  = 0;
+		base  = (uintptr_t) (current + 1);
+		start = (base + align - 1) & ~(uintptr_t) (align - 1);
+	}
+	uint64 end = start + size - base;
+	used  += end - offset;
+	offset = end;
+	if (used > highWater)
+		highWater = used;
+	return (void *) start;
+}
+
+GenoScratchMark GenoScratchAllocator::getMark() const {
+	return { current, offset, used };
+}
+
+void GenoScratchAllocator::rewind(const GenoScratchMark & mark) {
+	current = (GenoScratchBlock *) mark.block;
+	offset  = mark.offset;
+	used    = mark.used;
+}
+
+void GenoScratchAllocator::reset() {
+	current = 0;
+	offset  = 0;
+	used    = 0;
+}
+
+uint64 GenoScratchAllocator::getUsed() const {
+	return used;
+}
+
+uint64 GenoScratchAllocator::getHighWater() const {
+	return highWater;
+}
+
+void GenoScratchAllocator::resetHighWater() {
+	highWater = used;
+}
+
+GenoScratchAllocator::~GenoScratchAllocator() {
+	while (first != 0) {
+		GenoScratchBlock * next = first->next;
+		::operator delete(first);
+		first = next;
+	}
+}
\ No newline at end of file
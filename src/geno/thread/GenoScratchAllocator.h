@@ -0,0 +1,134 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_SCRATCH_ALLOCATOR
+#define GNARLY_GENOME_SCRATCH_ALLOCATOR
+
+#include <type_traits>
+
+#include "../GenoInts.h"
+
+/**
+ * The default size of each block a scratch allocator takes from the heap
+**/
+#define GENO_SCRATCH_ALLOCATOR_BLOCK_SIZE 0x10000
+
+/**
+ * A point in a scratch allocator to rewind to
+**/
+struct GenoScratchMark {
+	void * block;
+	uint64 offset;
+	uint64 used;
+};
+
+/**
+ * A bump allocator for short lived memory owned by a single thread
+ *
+ * Allocating moves a pointer through large blocks taken from the heap, and nothing is freed
+ * individually. Instead the allocator is rewound to a mark taken earlier, which releases
+ * everything allocated since in one go. Blocks are kept once allocated so a thread that
+ * repeatedly does the same work stops touching the heap.
+**/
+class GenoScratchAllocator {
+	private:
+		struct GenoScratchBlock {
+			GenoScratchBlock * next;
+			uint64 size;
+		};
+
+		uint64 blockSize;
+		GenoScratchBlock * first;
+		GenoScratchBlock * current;
+		uint64 offset;
+		uint64 used;
+		uint64 highWater;
+
+		static GenoScratchBlock * createBlock(uint64 size, GenoScratchBlock * next);
+
+	public:
+		/**
+		 * @param blockSize - The size of each block taken from the heap, larger allocations get a block of their own
+		**/
+		GenoScratchAllocator(uint64 blockSize = GENO_SCRATCH_ALLOCATOR_BLOCK_SIZE);
+
+		GenoScratchAllocator(const GenoScratchAllocator & allocator) = delete;
+		GenoScratchAllocator & operator=(const GenoScratchAllocator & allocator) = delete;
+
+		/**
+		 * Allocates uninitialized memory that stays valid until the allocator is rewound past it
+		 *
+		 * @param size - The number of bytes
+		 * @param align - The alignment of the memory, a power of two
+		**/
+		void * allocate(uint64 size, uint64 align = 16);
+
+		/**
+		 * Allocates an uninitialized array
+		 *
+		 * @param count - The number of elements
+		**/
+		template <typename T>
+		T * allocate(uint64 count) {
+			static_assert(std::is_trivially_destructible<T>::value, "GenoScratchAllocator arrays are never destroyed, use a trivially destructible type!");
+			return (T *) allocate(sizeof(T) * count, alignof(T));
+		}
+
+		/**
+		 * Returns the current position to rewind to later
+		**/
+		GenoScratchMark getMark() const;
+
+		/**
+		 * Releases everything allocated since a mark was taken
+		**/
+		void rewind(const GenoScratchMark & mark);
+
+		/**
+		 * Releases everything
+		**/
+		void reset();
+
+		/**
+		 * Returns the number of bytes currently allocated, including alignment padding
+		**/
+		uint64 getUsed() const;
+
+		/**
+		 * Returns the most bytes that have been allocated at once since creation or resetHighWater
+		**/
+		uint64 getHighWater() const;
+
+		/**
+		 * Starts tracking the high water mark again from what is currently allocated
+		**/
+		void resetHighWater();
+
+		~GenoScratchAllocator();
+};
+
+#define GNARLY_GENOME_SCRATCH_ALLOCATOR_FORWARD
+#endif // GNARLY_GENOME_SCRATCH_ALLOCATOR
\ No newline at end of file
@@ -0,0 +1,213 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include "GenoTaskGraph.h"
+
+GenoTask::GenoTask() :
+	graph(0),
+	index(0) {}
+
+GenoTask::GenoTask(GenoTaskGraph * graph, uint32 index) :
+	graph(graph),
+	index(index) {}
+
+GenoTask & GenoTask::precede(GenoTask task) {
+	// Default constructed handles belong to no graph and handles from different graphs cannot be linked
+	if (graph != 0 && task.graph == graph)
+		graph->addEdge(index, task.index);
+	return *this;
+}
+
+GenoTask & GenoTask::succeed(GenoTask task) {
+	if (graph != 0 && task.graph == graph)
+		graph->addEdge(task.index, index);
+	return *this;
+}
+
+uint32 GenoTask::getIndex() const {
+	return index;
+}
+
+GenoTaskGraph::GenoTaskGraph(uint32 initialCapacity) :
+	tasks(initialCapacity),
+	edges(initialCapacity),
+	compiled(false),
+	acyclic(false),
+	taskCapacity(0),
+	edgeCapacity(0),
+	states(0),
+	predecessorCounts(0),
+	successorOffsets(0),
+	successors(0),
+	order(0),
+	roots(initialCapacity),
+	pool(0),
+	priority(GENO_THREAD_POOL_PRIORITY_NORMAL) {}
+
+void GenoTaskGraph::taskJob(GenoThreadPoolJobData data) {
+	GenoTaskState * state = (GenoTaskState *) data;
+	GenoTaskGraph * graph = state->graph;
+	while (state != 0) {
+		GenoTaskNode & task = graph->tasks[state->index];
+		task.job(task.data);
+
+		// The last ready successor runs here instead of going through the pool
+		GenoTaskState * next = 0;
+		for (uint32 i = graph->successorOffsets[state->index]; i < graph->successorOffsets[state->index + 1]; ++i) {
+			GenoTaskState * successor = graph->states + graph->successors[i];
+			if (successor->remainingPredecessors.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				if (next != 0)
+					graph->pool->submitJob(taskJob, next, graph->priority);
+				next = successor;
+			}
+		}
+		graph->pool->finishCounted(graph->pendingTasks);
+		state = next;
+	}
+}
+
+void GenoTaskGraph::addEdge(uint32 from, uint32 to) {
+	GenoTaskEdge edge = { from, to };
+	edges.add(edge);
+	compiled = false;
+}
+
+bool GenoTaskGraph::compile() {
+	uint32 numTasks = tasks.getLength();
+	uint32 numEdges = edges.getLength();
+	if (numTasks > taskCapacity) {
+		delete [] states;
+		delete [] predecessorCounts;
+		delete [] successorOffsets;
+		delete [] order;
+		taskCapacity = numTasks;
+		states            = new GenoTaskState[taskCapacity];
+		predecessorCounts = new uint32[taskCapacity];
+		successorOffsets  = new uint32[taskCapacity + 1];
+		order             = new uint32[taskCapacity];
+	}
+	if (numEdges > edgeCapacity) {
+		delete [] successors;
+		edgeCapacity = numEdges;
+		successors = new uint32[edgeCapacity];
+	}
+
+	// Successors are stored contiguously per task, offsets are built with a prefix sum over out degrees
+	for (uint32 i = 0; i <= numTasks; ++i)
+		successorOffsets[i] = 0;
+	for (uint32 i = 0; i < numTasks; ++i)
+		predecessorCounts[i] = 0;
+	for (uint32 i = 0; i < numEdges; ++i) {
+		++successorOffsets[edges[i].from + 1];
+		++predecessorCounts[edges[i].to];
+	}
+	for (uint32 i = 0; i < numTasks; ++i)
+		successorOffsets[i + 1] += successorOffsets[i];
+	for (uint32 i = 0; i < numEdges; ++i)
+		successors[successorOffsets[edges[i].from]++] = edges[i].to;
+	for (uint32 i = numTasks; i > 0; --i)
+		successorOffsets[i] = successorOffsets[i - 1];
+	successorOffsets[0] = 0;
+
+	roots.clear();
+	for (uint32 i = 0; i < numTasks; ++i) {
+		states[i].graph = this;
+		states[i].index = i;
+		if (predecessorCounts[i] == 0)
+			roots.add(i);
+	}
+
+	// Kahn's algorithm, every task is reachable from a root unless it is on or behind a cycle
+	uint32 reached = 0;
+	for (uint32 i = 0; i < roots.getLength(); ++i)
+		order[reached++] = roots[i];
+	for (uint32 i = 0; i < numTasks; ++i)
+		states[i].remainingPredecessors.store(predecessorCounts[i], std::memory_order_relaxed);
+	for (uint32 i = 0; i < reached; ++i)
+		for (uint32 j = successorOffsets[order[i]]; j < successorOffsets[order[i] + 1]; ++j)
+			if (states[successors[j]].remainingPredecessors.fetch_sub(1, std::memory_order_relaxed) == 1)
+				order[reached++] = successors[j];
+
+	acyclic  = reached == numTasks;
+	compiled = true;
+	return acyclic;
+}
+
+GenoTask GenoTaskGraph::addTask(GenoThreadPoolJob job, GenoThreadPoolJobData data) {
+	GenoTaskNode task = { job, data };
+	tasks.add(task);
+	compiled = false;
+	return GenoTask(this, tasks.getLength() - 1);
+}
+
+void GenoTaskGraph::setTaskData(GenoTask task, GenoThreadPoolJobData data) {
+	tasks[task.index].data = data;
+}
+
+bool GenoTaskGraph::run(GenoThreadPool * pool, uint32 priority) {
+	if (!compiled)
+		compile();
+	if (!acyclic)
+		return false;
+
+	uint32 numTasks = tasks.getLength();
+	if (numTasks == 0)
+		return true;
+
+	if (pool == 0) {
+		for (uint32 i = 0; i < numTasks; ++i)
+			tasks[order[i]].job(tasks[order[i]].data);
+		return true;
+	}
+
+	this->pool     = pool;
+	this->priority = priority;
+	for (uint32 i = 0; i < numTasks; ++i)
+		states[i].remainingPredecessors.store(predecessorCounts[i], std::memory_order_relaxed);
+	pendingTasks.count.store(numTasks, std::memory_order_relaxed);
+	for (uint32 i = 0; i < roots.getLength(); ++i)
+		pool->submitJob(taskJob, states + roots[i], priority);
+	pool->wait(pendingTasks);
+	return true;
+}
+
+void GenoTaskGraph::clear() {
+	tasks.clear();
+	edges.clear();
+	compiled = false;
+}
+
+uint32 GenoTaskGraph::getTaskCount() const {
+	return tasks.getLength();
+}
+
+GenoTaskGraph::~GenoTaskGraph() {
+	delete [] states;
+	delete [] predecessorCounts;
+	delete [] successorOffsets;
+	delete [] successors;
+	delete [] order;
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_TASK_GRAPH_FORWARD
+#define GNARLY_GENOME_TASK_GRAPH_FORWARD
+
+class GenoTask;
+class GenoTaskGraph;
+
+#endif // GNARLY_GENOME_TASK_GRAPH_FORWARD
+
+#ifndef GNARLY_GENOME_TASK_GRAPH
+#define GNARLY_GENOME_TASK_GRAPH
+
+#include <atomic>
+
+#include "../GenoInts.h"
+#include "../template/GenoArrayList.h"
+#include "GenoThreadPool.h"
+
+/**
+ * A handle to a task in a GenoTaskGraph
+ *
+ * A default constructed handle refers to no task until one returned by GenoTaskGraph is assigned to it.
+ * Linking it, or linking tasks of two different graphs, does nothing.
+**/
+class GenoTask {
+	private:
+		GenoTaskGraph * graph;
+		uint32 index;
+
+		GenoTask(GenoTaskGraph * graph, uint32 index);
+	public:
+		GenoTask();
+
+		/**
+		 * Makes task wait for this task to finish
+		 *
+		 * @param task - The task to run after this one
+		**/
+		GenoTask & precede(GenoTask task);
+
+		/**
+		 * Makes this task wait for task to finish
+		 *
+		 * @param task - The task to run before this one
+		**/
+		GenoTask & succeed(GenoTask task);
+
+		uint32 getIndex() const;
+
+	friend class GenoTaskGraph;
+};
+
+/**
+ * A set of jobs with dependencies between them
+ *
+ * Running the graph submits every task without predecessors to the pool, then submits each other
+ * task as soon as its last predecessor finishes. The graph keeps its tasks and edges between runs so
+ * it can be built once and run every frame. Building the graph allocates, running it does not unless
+ * the graph has changed since the last run.
+**/
+class GenoTaskGraph {
+	private:
+		struct GenoTaskNode {
+			GenoThreadPoolJob job;
+			GenoThreadPoolJobData data;
+		};
+
+		struct GenoTaskEdge {
+			uint32 from;
+			uint32 to;
+		};
+
+		struct GenoTaskState {
+			GenoTaskGraph * graph;
+			uint32 index;
+			std::atomic<uint32> remainingPredecessors;
+		};
+
+		GenoArrayList<GenoTaskNode> tasks;
+		GenoArrayList<GenoTaskEdge> edges;
+
+		bool compiled;
+		bool acyclic;
+		uint32 taskCapacity;
+		uint32 edgeCapacity;
+		GenoTaskState * states;
+		uint32 * predecessorCounts;
+		uint32 * successorOffsets;
+		uint32 * successors;
+		uint32 * order;
+		GenoArrayList<uint32> roots;
+
+		GenoThreadPool * pool;
+		uint32 priority;
+		GenoJobCounter pendingTasks;
+
+		static void taskJob(GenoThreadPoolJobData data);
+
+		bool compile();
+		void addEdge(uint32 from, uint32 to);
+	public:
+
+		/**
+		 * Creates an empty task graph
+		 *
+		 * @param initialCapacity - The number of tasks to reserve space for
+		**/
+		GenoTaskGraph(uint32 initialCapacity = 16);
+
+		GenoTaskGraph(const GenoTaskGraph & graph) = delete;
+
+		/**
+		 * Adds a task to the graph
+		 *
+		 * @param job - The job to run
+		 * @param data - The data for the job
+		**/
+		GenoTask addTask(GenoThreadPoolJob job, GenoThreadPoolJobData data = 0);
+
+		/**
+		 * Replaces the data passed to a task's job on the next run
+		**/
+		void setTaskData(GenoTask task, GenoThreadPoolJobData data);
+
+		/**
+		 * Runs every task in the graph and returns once all of them have finished
+		 *
+		 * The calling thread helps with queued jobs while it waits. Returns false without running
+		 * anything if the dependencies contain a cycle.
+		 *
+		 * @param pool - The pool to run the tasks on, null runs them in order on the calling thread
+		 * @param priority - The priority to run the tasks at, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		bool run(GenoThreadPool * pool = 0, uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL);
+
+		/**
+		 * Removes every task and dependency, keeping the memory for the next build
+		**/
+		void clear();
+
+		uint32 getTaskCount() const;
+
+		~GenoTaskGraph();
+
+	friend class GenoTask;
+};
+
+#define GNARLY_GENOME_TASK_GRAPH_FORWARD
+#endif // GNARLY_GENOME_TASK_GRAPH
\ No newline at end of file
@@ -25,80 +25,807 @@
  *******************************************************************************/
 
 #include <mutex>
+#include <chrono>
+#include <cstdio>
 #include <memory>
 
+#include "GenoTime.h"
+#include "GenoCpuTopology.h"
+
 #include "GenoThreadPool.h"
 
+/**
+ * With no grain given, ranges are cut into about this many pieces per thread (the caller counts)
+**/
+#define GENO_PARALLEL_FOR_GRAINS_PER_THREAD 8
+
+namespace {
+	thread_local GenoThreadPool * currentPool = 0;
+	thread_local uint32 currentThread = 0;
+	thread_local uint32 currentPriority = GENO_THREAD_POOL_PRIORITY_NORMAL;
+	thread_local uint32 randomState = 1;
+	thread_local uint32 jobDepth = 0;
+	thread_local bool backgroundSlot = false;
+	thread_local GenoScratchAllocator threadScratch;
+
+	uint32 nextRandom() {
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return randomState;
+	}
+
+	void raiseTo(std::atomic<uint64> & value, uint64 candidate) {
+		uint64 current = value.load(std::memory_order_relaxed);
+		while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed));
+	}
+}
+
+GenoJobCounter::GenoJobCounter() :
+	count(0),
+	continuationJob(0),
+	continuationData(0),
+	continuationPriority(GENO_THREAD_POOL_PRIORITY_NORMAL) {}
+
+uint32 GenoJobCounter::getCount() const {
+	return count.load(std::memory_order_acquire) & ~GENO_JOB_COUNTER_CONTINUATION;
+}
+
+bool GenoJobCounter::isDone() const {
+	// A counter with a continuation still pending is not done yet. Sequentially consistent so a
+	// parking waiter and the finishing job cannot both miss each other, see GenoThreadPool::wait
+	return count.load() == 0;
+}
+
 void GenoThreadPool::threadLoop(uint32 threadId, GenoThreadPool * pool) {
-	while (pool->isActive.load()) {
-		GenoThreadPoolJobPackage * job = pool->requestJob(threadId);
-		if (job != 0) {
-			job->job(job->data);
-			pool->activeThreads[threadId].store(false);
+	currentPool   = pool;
+	currentThread = threadId;
+	randomState   = 0x9E3779B9 * (threadId + 1);
+	if (pool->pinWorkers)
+		GenoCpuTopology::pinCurrentThread(pool->workerCpus[threadId]);
+	else if (pool->numAllowedCpus > 0)
+		GenoCpuTopology::restrictCurrentThread(pool->numAllowedCpus, pool->allowedCpus);
+	pool->counters[threadId].idleSince = pool->collectStats.load(std::memory_order_relaxed) ? GenoTime::now() : 0;
+
+	GenoThreadPoolJobPackage job;
+	uint32 priority;
+	uint32 spins = 0;
+	while (true) {
+		if (pool->requestJob(threadId, job, priority)) {
+			if (spins > 0)
+				--pool->spinningThreads;
+			spins = 0;
+			pool->runJob(job, priority, threadId);
+		}
+		else if (pool->hasRunnableJob(true))
+			// A steal lost its race, the job is still somewhere
+			std::this_thread::yield();
+		else if (spins < pool->spinCount) {
+			// Parking and waking cost far more than a short burst of jobs takes to arrive
+			if (spins++ == 0)
+				++pool->spinningThreads;
+			std::this_thread::yield();
+		}
+		else {
+			if (spins > 0)
+				--pool->spinningThreads;
+			spins = 0;
+			bool woken = true;
+			{
+				std::unique_lock<std::mutex> lock(pool->parkMutex);
+				auto wake = [pool] { return pool->hasRunnableJob(true) || !pool->isActive.load(); };
+				++pool->sleepingThreads;
+				if (pool->idleTimeout == 0)
+					pool->jobCondition.wait(lock, wake);
+				else
+					woken = pool->jobCondition.wait_for(lock, std::chrono::nanoseconds(pool->idleTimeout), wake);
+				--pool->sleepingThreads;
+				if (!pool->isActive.load() && pool->queuedJobs.load() <= 0)
+					return;
+			}
+			if (!woken && pool->retireWorker(threadId))
+				return;
 		}
-		else
-			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(1));
 	}
 }
 
-GenoThreadPool::GenoThreadPoolJobPackage * GenoThreadPool::requestJob(uint32 threadId) {
-	std::lock_guard<std::mutex> lock(jobMutex);
-	if (jobCount > 0) {
-		activeThreads[threadId].store(true);
-		--jobCount;
-		return &jobs[jobCount];
+bool GenoThreadPool::hasRunnableJob(bool worker) const {
+	// Sequentially consistent against the submitter's increment followed by its read of sleepingThreads,
+	// otherwise a parking worker could miss the job while the submitter misses the parked worker
+	if (priorityJobs[GENO_THREAD_POOL_PRIORITY_CRITICAL].load() > 0 || priorityJobs[GENO_THREAD_POOL_PRIORITY_NORMAL].load() > 0)
+		return true;
+	if (priorityJobs[GENO_THREAD_POOL_PRIORITY_BACKGROUND].load() <= 0)
+		return false;
+	return worker ? backgroundSlot || backgroundThreads.load() < maxBackgroundThreads : numThreads == 0;
+}
+
+bool GenoThreadPool::requestJob(uint32 threadId, GenoThreadPoolJobPackage & job, uint32 & priority) {
+	bool worker = threadId < numThreads;
+	for (priority = 0; priority < GENO_THREAD_POOL_PRIORITIES; ++priority) {
+		if (priorityJobs[priority].load(std::memory_order_relaxed) <= 0)
+			continue;
+		// A worker already inside a background job keeps its slot for the jobs it runs while waiting,
+		// otherwise a background job waiting on background children could never see them run
+		bool claim = priority == GENO_THREAD_POOL_PRIORITY_BACKGROUND && worker && !backgroundSlot;
+		if (priority == GENO_THREAD_POOL_PRIORITY_BACKGROUND) {
+			// Threads helping out in a wait leave background jobs to the workers unless there are none
+			if (!worker && numThreads > 0)
+				return false;
+			if (claim && backgroundThreads.fetch_add(1) >= maxBackgroundThreads) {
+				--backgroundThreads;
+				return false;
+			}
+		}
+		if (takeJob(threadId, priority, job)) {
+			--priorityJobs[priority];
+			--queuedJobs;
+			return true;
+		}
+		if (claim)
+			--backgroundThreads;
 	}
-	else
-		return 0;
+	return false;
+}
+
+bool GenoThreadPool::takeJob(uint32 threadId, uint32 priority, GenoThreadPoolJobPackage & job) {
+	if (threadId < numThreads && deques[threadId * GENO_THREAD_POOL_PRIORITIES + priority]->pop(job))
+		return true;
+	if (sharedJobs[priority].load(std::memory_order_relaxed) > 0) {
+		std::unique_lock<std::mutex> lock(jobMutex, std::defer_lock);
+		lockJobs(lock, threadId);
+		if (jobs[priority].getLength() > 0) {
+			job = jobs[priority].dequeue();
+			--sharedJobs[priority];
+			return true;
+		}
+	}
+	if (numThreads == 0)
+		return false;
+	// Workers try their own cache domain first, the row past the last worker lists every worker for outside threads
+	uint32 row = threadId < numThreads ? threadId : numThreads;
+	const uint32 * victims = stealOrder + row * numThreads;
+	uint32 numVictims = threadId < numThreads ? numThreads - 1 : numThreads;
+	return stealJob(row, victims, localVictims[row], priority, job) || stealJob(row, victims + localVictims[row], numVictims - localVictims[row], priority, job);
+}
+
+bool GenoThreadPool::stealJob(uint32 threadId, const uint32 * victims, uint32 numVictims, uint32 priority, GenoThreadPoolJobPackage & job) {
+	if (numVictims == 0)
+		return false;
+	GenoThreadPoolCounters & counter = counters[threadId < numThreads ? threadId : numThreads];
+	uint32 start = nextRandom() % numVictims;
+	for (uint32 i = 0; i < numVictims; ++i) {
+		counter.stealAttempts.fetch_add(1, std::memory_order_relaxed);
+		if (deques[victims[(start + i) % numVictims] * GENO_THREAD_POOL_PRIORITIES + priority]->steal(job)) {
+			counter.steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void GenoThreadPool::runJob(GenoThreadPoolJobPackage & job, uint32 priority, uint32 threadId) {
+	bool worker = threadId < numThreads;
+	GenoThreadPoolCounters & counter = counters[worker ? threadId : numThreads];
+	bool timed = collectStats.load(std::memory_order_relaxed);
+	uint64 start = 0;
+	if (timed) {
+		start = GenoTime::now();
+		if (job.queuedTime != 0) {
+			uint64 latency = start > job.queuedTime ? (start - job.queuedTime) / 1000 : 0;
+			uint32 bucket = 0;
+			while (latency > 0 && bucket < GENO_THREAD_POOL_LATENCY_BUCKETS - 1) {
+				latency >>= 1;
+				++bucket;
+			}
+			counter.latencies[bucket].fetch_add(1, std::memory_order_relaxed);
+		}
+		if (worker && jobDepth == 0 && counter.idleSince != 0)
+			counter.idleTime.fetch_add(start - counter.idleSince, std::memory_order_relaxed);
+	}
+
+	if (minThreads < numThreads) {
+		uint64 now = timed ? start : GenoTime::now();
+		lastJobStart.store(now, std::memory_order_relaxed);
+		if (job.queuedTime != 0 && now > job.queuedTime && queuedJobs.load(std::memory_order_relaxed) > 0)
+			scaleUp(now - job.queuedTime);
+	}
+
+	// Matches the claim in requestJob, only the outermost background job on a worker holds a slot
+	bool claimed = worker && priority == GENO_THREAD_POOL_PRIORITY_BACKGROUND && !backgroundSlot;
+	GenoScratchAllocator & scratch = getScratch();
+	// The allocator belongs to this thread, so a stats reset is only applied to it here
+	if (counter.scratchReset.load(std::memory_order_relaxed) && counter.scratchReset.exchange(false, std::memory_order_relaxed))
+		scratch.resetHighWater();
+	GenoScratchMark mark = scratch.getMark();
+	uint32 outerPriority = currentPriority;
+	currentPriority = priority;
+	backgroundSlot = backgroundSlot || claimed;
+	++jobDepth;
+	job.invoke(job);
+	--jobDepth;
+	backgroundSlot = backgroundSlot && !claimed;
+	currentPriority = outerPriority;
+	scratch.rewind(mark);
+	counter.jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+	raiseTo(counter.scratchHighWater, scratch.getHighWater());
+
+	// Jobs run while helping inside another job count towards the outer job's busy time
+	if (jobDepth == 0) {
+		uint64 end = 0;
+		if (timed) {
+			end = GenoTime::now();
+			counter.busyTime.fetch_add(end - start, std::memory_order_relaxed);
+			uint64 due = nextDump.load(std::memory_order_relaxed);
+			const char * path = dumpPath.load(std::memory_order_acquire);
+			if (worker && path && end >= due && nextDump.compare_exchange_strong(due, end + dumpInterval.load(std::memory_order_relaxed)))
+				dumpStats(path);
+		}
+		if (worker)
+			counter.idleSince = end;
+	}
+
+	if (claimed) {
+		--backgroundThreads;
+		// A worker may have parked on the background limit with background jobs still queued
+		if (priorityJobs[GENO_THREAD_POOL_PRIORITY_BACKGROUND].load() > 0 && sleepingThreads.load() > 0) {
+			std::lock_guard<std::mutex> lock(parkMutex);
+			jobCondition.notify_one();
+		}
+	}
+	finishJob();
+}
+
+void GenoThreadPool::lockJobs(std::unique_lock<std::mutex> & lock, uint32 threadId) {
+	// The clock is only read when the lock is contended
+	if (!collectStats.load(std::memory_order_relaxed)) {
+		lock.lock();
+		return;
+	}
+	if (lock.try_lock())
+		return;
+	uint64 start = GenoTime::now();
+	lock.lock();
+	counters[threadId < numThreads ? threadId : numThreads].lockWaitTime.fetch_add(GenoTime::now() - start, std::memory_order_relaxed);
+}
+
+void GenoThreadPool::resetCounters(GenoThreadPoolCounters & counter) {
+	counter.jobsExecuted.store(0, std::memory_order_relaxed);
+	counter.busyTime.store(0, std::memory_order_relaxed);
+	counter.idleTime.store(0, std::memory_order_relaxed);
+	counter.stealAttempts.store(0, std::memory_order_relaxed);
+	counter.steals.store(0, std::memory_order_relaxed);
+	counter.queueHighWater.store(0, std::memory_order_relaxed);
+	counter.lockWaitTime.store(0, std::memory_order_relaxed);
+	counter.scratchHighWater.store(0, std::memory_order_relaxed);
+	counter.scratchReset.store(true, std::memory_order_relaxed);
+	for (uint32 i = 0; i < GENO_THREAD_POOL_LATENCY_BUCKETS; ++i)
+		counter.latencies[i].store(0, std::memory_order_relaxed);
+}
+
+GenoThreadPoolCreateInfo GenoThreadPool::createInfo(uint32 numThreads, uint32 initialQueueCapacity) {
+	GenoThreadPoolCreateInfo info = {};
+	info.numThreads           = numThreads;
+	info.initialQueueCapacity = initialQueueCapacity;
+	return info;
+}
+
+void GenoThreadPool::placeWorkers(const GenoThreadPoolCreateInfo & info) {
+	uint32 numCpus = GenoCpuTopology::getLogicalCpuCount();
+	uint32 reservedCore = GenoCpuTopology::getCoreCount();
+	if (info.reserveCallerCore) {
+		uint32 callerCpu = GenoCpuTopology::getCurrentCpu();
+		if (callerCpu < numCpus) {
+			reservedCore = GenoCpuTopology::getLogicalCpu(callerCpu).core;
+			if (info.pinWorkers)
+				GenoCpuTopology::pinCurrentThread(callerCpu);
+		}
+	}
+
+	// Cpus are sorted by cache domain, so taking first siblings in order fills one domain before the next
+	uint32 * candidates = new uint32[numCpus];
+	uint32 numCandidates = 0;
+	for (uint32 smtIndex = 0; numCandidates < numCpus; ++smtIndex) {
+		uint32 added = 0;
+		for (uint32 i = 0; i < numCpus; ++i) {
+			const GenoLogicalCpu & cpu = GenoCpuTopology::getLogicalCpu(i);
+			if (cpu.smtIndex == smtIndex) {
+				if (cpu.core != reservedCore)
+					candidates[numCandidates++] = i;
+				++added;
+			}
+		}
+		if (added == 0)
+			break;
+	}
+	// Unpinned workers still keep off the reserved core, as long as there is another to run on
+	if (info.reserveCallerCore && !info.pinWorkers && numCandidates > 0 && numCandidates < numCpus) {
+		numAllowedCpus = numCandidates;
+		allowedCpus    = new uint32[numCandidates];
+		memcpy(allowedCpus, candidates, numCandidates * sizeof(uint32));
+	}
+	if (numCandidates == 0)
+		candidates[numCandidates++] = 0;
+	for (uint32 i = 0; i < numThreads; ++i)
+		workerCpus[i] = candidates[i % numCandidates];
+	delete [] candidates;
+
+	auto sameDomain = [this](uint32 a, uint32 b) {
+		return GenoCpuTopology::getLogicalCpu(workerCpus[a]).cacheDomain == GenoCpuTopology::getLogicalCpu(workerCpus[b]).cacheDomain;
+	};
+	for (uint32 i = 0; i <= numThreads; ++i) {
+		uint32 * victims = stealOrder + i * numThreads;
+		bool local = i < numThreads && info.localStealing;
+		uint32 numVictims = 0;
+		if (local)
+			for (uint32 j = 0; j < numThreads; ++j)
+				if (j != i && sameDomain(i, j))
+					victims[numVictims++] = j;
+		localVictims[i] = numVictims;
+		for (uint32 j = 0; j < numThreads; ++j)
+			if (j != i && !(local && sameDomain(i, j)))
+				victims[numVictims++] = j;
+	}
+}
+
+void GenoThreadPool::parallelForJob(GenoParallelForContext * context, uint64 begin, uint64 end) {
+	GenoThreadPool * pool = context->pool;
+	bool onWorker = currentPool == pool;
+	while (begin < end) {
+		// Only split once nobody is left to take the previous split, which keeps splitting proportional to demand
+		if (end - begin > context->grain && (!onWorker || pool->deques[currentThread * GENO_THREAD_POOL_PRIORITIES + context->priority]->getLength() == 0)) {
+			// The split range travels in the job slot itself, so splitting allocates nothing
+			uint64 middle = begin + ((end - begin) >> 1);
+			context->pendingRanges.count.fetch_add(1, std::memory_order_relaxed);
+			pool->submitJob([context, middle, end] { parallelForJob(context, middle, end); }, context->priority);
+			end = middle;
+		}
+		else {
+			uint64 stop = end - begin > context->grain ? begin + context->grain : end;
+			context->body(context->func, begin, stop);
+			begin = stop;
+		}
+	}
+	// The context lives on the caller's stack, it may be gone once this is released
+	pool->finishCounted(context->pendingRanges);
+}
+
+void GenoThreadPool::invokeRawJob(GenoThreadPoolJobPackage & package) {
+	GenoThreadPoolRawJob * raw = (GenoThreadPoolRawJob *) package.storage;
+	raw->job(raw->data);
+}
+
+void GenoThreadPool::invokeCountedRawJob(GenoThreadPoolJobPackage & package) {
+	GenoThreadPoolRawJob * raw = (GenoThreadPoolRawJob *) package.storage;
+	raw->job(raw->data);
+	raw->pool->finishCounted(*raw->counter);
+}
+
+bool GenoThreadPool::runQueuedJob() {
+	GenoThreadPoolJobPackage job;
+	uint32 priority;
+	uint32 threadId = currentPool == this ? currentThread : numThreads;
+	if (!requestJob(threadId, job, priority))
+		return false;
+	runJob(job, priority, threadId);
+	return true;
+}
+
+void GenoThreadPool::parallelForRange(GenoParallelForBody body, const void * func, uint64 begin, uint64 end, uint64 grain) {
+	uint64 length = end - begin;
+	if (grain == 0) {
+		uint64 pieces = (uint64) (numThreads + 1) * GENO_PARALLEL_FOR_GRAINS_PER_THREAD;
+		grain = (length + pieces - 1) / pieces;
+	}
+	if (numThreads == 0 || length <= grain) {
+		body(func, begin, end);
+		return;
+	}
+
+	GenoParallelForContext context;
+	context.pool   = this;
+	context.body   = body;
+	context.func   = func;
+	context.grain  = grain;
+	context.priority = currentPool == this ? currentPriority : GENO_THREAD_POOL_PRIORITY_NORMAL;
+	context.pendingRanges.count.store(1, std::memory_order_relaxed);
+
+	parallelForJob(&context, begin, end);
+	wait(context.pendingRanges);
+}
+
+uint64 GenoThreadPool::reduceBlockLength(uint64 length, uint64 grain) const {
+	if (numThreads == 0)
+		return length;
+	if (grain != 0)
+		return grain;
+	uint64 numBlocks = (uint64) (numThreads + 1) * GENO_PARALLEL_REDUCE_BLOCKS_PER_THREAD;
+	return (length + numBlocks - 1) / numBlocks;
+}
+
+void GenoThreadPool::finishJob() {
+	if (pendingJobs.fetch_sub(1) == 1) {
+		// Taking the lock orders the notify after a waiter has checked pendingJobs
+		std::lock_guard<std::mutex> lock(parkMutex);
+		waitCondition.notify_all();
+	}
+}
+
+void GenoThreadPool::finishCounted(GenoJobCounter & counter) {
+	// The release and the read of counterWaiters are sequentially consistent, as are the waiter's
+	// increment of counterWaiters and its check of the counter, so at least one side sees the other
+	uint32 previous = counter.count.fetch_sub(1);
+	if (previous == (GENO_JOB_COUNTER_CONTINUATION | 1)) {
+		// Nobody else can see the counter as done until the continuation bit is cleared
+		GenoThreadPoolJob job = counter.continuationJob;
+		GenoThreadPoolJobData data = counter.continuationData;
+		uint32 priority = counter.continuationPriority;
+		counter.count.store(0);
+		submitJob(job, data, priority);
+	}
+	// Only the pool is touched once the counter is done, the waiter may already have destroyed it
+	if ((previous & ~GENO_JOB_COUNTER_CONTINUATION) == 1 && counterWaiters.load() > 0) {
+		std::lock_guard<std::mutex> lock(parkMutex);
+		waitCondition.notify_all();
+	}
+}
+
+GenoScratchAllocator & GenoThreadPool::getScratch() {
+	return currentPool ? *currentPool->scratchAllocators[currentThread] : threadScratch;
 }
 
 uint32 GenoThreadPool::physicalThreadCount() {
-	return std::thread::hardware_concurrency();
+	return GenoCpuTopology::getCoreCount();
 }
 
 GenoThreadPool::GenoThreadPool(uint32 numThreads, uint32 initialQueueCapacity) :
+	GenoThreadPool(createInfo(numThreads, initialQueueCapacity)) {}
+
+GenoThreadPool::GenoThreadPool(const GenoThreadPoolCreateInfo & info) :
 	isActive(true),
-	numThreads(numThreads),
-	threads(new std::thread[numThreads]),
-	activeThreads(new std::atomic_bool[numThreads]),
-	jobCount(0),
-	jobCapacity(initialQueueCapacity == 0 ? 16 : initialQueueCapacity),
-	jobs(new GenoThreadPoolJobPackage[jobCapacity]) {
+	numThreads(info.numThreads),
+	threads(new std::thread[info.numThreads]),
+	minThreads(info.idleTimeout == 0 || info.minThreads > info.numThreads ? info.numThreads : info.minThreads),
+	spinCount(info.spinCount),
+	idleTimeout((uint64) info.idleTimeout * 1000000),
+	scaleUpLatency((uint64) (info.scaleUpLatency == 0 ? GENO_THREAD_POOL_DEFAULT_SCALE_UP_LATENCY : info.scaleUpLatency) * 1000),
+	liveThreads(0),
+	workerStates(new std::atomic<uint32>[info.numThreads]),
+	lastJobStart(GenoTime::now()),
+	lastScaleUp(0),
+	deques(new GenoWorkStealingDeque<GenoThreadPoolJobPackage> * [info.numThreads * GENO_THREAD_POOL_PRIORITIES]),
+	scratchAllocators(new GenoScratchAllocator * [info.numThreads]),
+	maxBackgroundThreads(info.maxBackgroundThreads == 0 || info.maxBackgroundThreads > info.numThreads ? info.numThreads : info.maxBackgroundThreads),
+	backgroundThreads(0),
+	sleepingThreads(0),
+	spinningThreads(0),
+	queuedJobs(0),
+	pendingJobs(0),
+	counterWaiters(0),
+	collectStats(info.collectStats),
+	counters(new GenoThreadPoolCounters[info.numThreads + 1]),
+	nextDump(0),
+	dumpInterval(0),
+	dumpPath(0),
+	pinWorkers(info.pinWorkers),
+	workerCpus(new uint32[info.numThreads]),
+	numAllowedCpus(0),
+	allowedCpus(0),
+	stealOrder(new uint32[(info.numThreads + 1) * info.numThreads]),
+	localVictims(new uint32[info.numThreads + 1]) {
+	for (uint32 i = 0; i < GENO_THREAD_POOL_PRIORITIES; ++i) {
+		jobs[i] = GenoQueue<GenoThreadPoolJobPackage>(info.initialQueueCapacity == 0 ? 16 : info.initialQueueCapacity);
+		sharedJobs[i].store(0);
+		priorityJobs[i].store(0);
+	}
+	for (uint32 i = 0; i <= numThreads; ++i)
+		resetCounters(counters[i]);
+	placeWorkers(info);
+	for (uint32 i = 0; i < numThreads * GENO_THREAD_POOL_PRIORITIES; ++i)
+		deques[i] = new GenoWorkStealingDeque<GenoThreadPoolJobPackage>(info.initialQueueCapacity);
 	for (uint32 i = 0; i < numThreads; ++i) {
+		scratchAllocators[i] = new GenoScratchAllocator(info.scratchBlockSize);
+		workerStates[i].store(GENO_THREAD_POOL_WORKER_STOPPED);
+	}
+	for (uint32 i = 0; i < minThreads; ++i)
+		startWorker();
+}
+
+void GenoThreadPool::submitJob(GenoThreadPoolJob job, GenoThreadPoolJobData data, uint32 priority) {
+	GenoThreadPoolJobPackage package;
+	package.invoke = invokeRawJob;
+	GenoThreadPoolRawJob raw = { job, data, this, 0 };
+	memcpy(package.storage, &raw, sizeof(raw));
+	submitPackage(package, priority);
+}
+
+void GenoThreadPool::submitJob(GenoJobCounter & counter, GenoThreadPoolJob job, GenoThreadPoolJobData data, uint32 priority) {
+	GenoThreadPoolJobPackage package;
+	package.invoke = invokeCountedRawJob;
+	GenoThreadPoolRawJob raw = { job, data, this, &counter };
+	memcpy(package.storage, &raw, sizeof(raw));
+	counter.count.fetch_add(1, std::memory_order_relaxed);
+	submitPackage(package, priority);
+}
+
+void GenoThreadPool::submitPackage(GenoThreadPoolJobPackage & package, uint32 priority) {
+	if (priority >= GENO_THREAD_POOL_PRIORITIES)
+		priority = GENO_THREAD_POOL_PRIORITY_BACKGROUND;
+	package.queuedTime = collectStats.load(std::memory_order_relaxed) || minThreads < numThreads ? GenoTime::now() : 0;
+	++pendingJobs;
+	if (currentPool == this) {
+		GenoWorkStealingDeque<GenoThreadPoolJobPackage> * deque = deques[currentThread * GENO_THREAD_POOL_PRIORITIES + priority];
+		deque->push(package);
+		raiseTo(counters[currentThread].queueHighWater, deque->getLength());
+	}
+	else {
+		std::unique_lock<std::mutex> lock(jobMutex, std::defer_lock);
+		lockJobs(lock, numThreads);
+		jobs[priority].enqueue(package);
+		++sharedJobs[priority];
+		raiseTo(counters[numThreads].queueHighWater, jobs[priority].getLength());
+	}
+	++priorityJobs[priority];
+	++queuedJobs;
+	wakeWorkers(1);
+	scaleUp(0);
+}
+
+void GenoThreadPool::submitRawJobs(GenoJobCounter * counter, uint32 num, GenoThreadPoolJob job, const GenoThreadPoolJobData data[], uint32 priority) {
+	if (num == 0)
+		return;
+	if (priority >= GENO_THREAD_POOL_PRIORITIES)
+		priority = GENO_THREAD_POOL_PRIORITY_BACKGROUND;
+	GenoThreadPoolJobPackage package;
+	package.invoke = counter ? invokeCountedRawJob : invokeRawJob;
+	package.queuedTime = collectStats.load(std::memory_order_relaxed) || minThreads < numThreads ? GenoTime::now() : 0;
+	GenoThreadPoolRawJob raw = { job, 0, this, counter };
+	if (counter)
+		counter->count.fetch_add(num, std::memory_order_relaxed);
+	pendingJobs += num;
+	if (currentPool == this) {
+		GenoWorkStealingDeque<GenoThreadPoolJobPackage> * deque = deques[currentThread * GENO_THREAD_POOL_PRIORITIES + priority];
+		deque->reserve(num);
+		for (uint32 i = 0; i < num; ++i) {
+			raw.data = data[i];
+			memcpy(package.storage, &raw, sizeof(raw));
+			deque->push(package);
+		}
+		raiseTo(counters[currentThread].queueHighWater, deque->getLength());
+	}
+	else {
+		std::unique_lock<std::mutex> lock(jobMutex, std::defer_lock);
+		lockJobs(lock, numThreads);
+		GenoQueue<GenoThreadPoolJobPackage> & queue = jobs[priority];
+		queue.reserve(queue.getLength() + num);
+		for (uint32 i = 0; i < num; ++i) {
+			raw.data = data[i];
+			memcpy(package.storage, &raw, sizeof(raw));
+			queue.enqueue(package);
+		}
+		sharedJobs[priority] += num;
+		raiseTo(counters[numThreads].queueHighWater, queue.getLength());
+	}
+	priorityJobs[priority] += num;
+	queuedJobs += num;
+	wakeWorkers(num);
+	scaleUp(0);
+}
+
+void GenoThreadPool::startWorker() {
+	std::lock_guard<std::mutex> lock(scaleMutex);
+	if (liveThreads.load() >= numThreads || !isActive.load())
+		return;
+	for (uint32 i = 0; i < numThreads; ++i) {
+		uint32 state = workerStates[i].load();
+		if (state == GENO_THREAD_POOL_WORKER_RUNNING)
+			continue;
+		if (state == GENO_THREAD_POOL_WORKER_EXITED)
+			threads[i].join();
+		workerStates[i].store(GENO_THREAD_POOL_WORKER_RUNNING);
+		++liveThreads;
 		threads[i] = std::thread(threadLoop, i, this);
-		activeThreads[i].store(false);
+		return;
 	}
 }
 
-void GenoThreadPool::submitJob(GenoThreadPoolJob job, GenoThreadPoolJobData data) {
-	std::lock_guard<std::mutex> lock(jobMutex);
-	if (jobCount >= jobCapacity) {
-		jobCapacity *= 2;
-		GenoThreadPoolJobPackage * newJobs = new GenoThreadPoolJobPackage[jobCapacity];
-		memcpy(newJobs, jobs, sizeof(GenoThreadPoolJobPackage) * jobCount);
-		delete [] jobs;
-		jobs = newJobs;
+void GenoThreadPool::scaleUp(uint64 latency) {
+	if (minThreads == numThreads)
+		return;
+	uint32 live = liveThreads.load();
+	if (live >= numThreads)
+		return;
+	if (live > 0) {
+		// A spinning worker picks up the job about as soon as a parked one would
+		if (sleepingThreads.load() > 0 || spinningThreads.load() > 0)
+			return;
+		// Without a measured latency, nobody parked and no job started for a while means the oldest queued job has waited at least that long
+		uint64 now = GenoTime::now();
+		if (latency == 0)
+			latency = now - lastJobStart.load(std::memory_order_relaxed);
+		if (latency < scaleUpLatency)
+			return;
+		uint64 last = lastScaleUp.load(std::memory_order_relaxed);
+		if (now - last < scaleUpLatency || !lastScaleUp.compare_exchange_strong(last, now, std::memory_order_relaxed))
+			return;
+	}
+	startWorker();
+}
+
+bool GenoThreadPool::retireWorker(uint32 threadId) {
+	// Holding scaleMutex keeps startWorker from seeing the slot half retired
+	std::lock_guard<std::mutex> lock(scaleMutex);
+	if (liveThreads.load() <= minThreads || !isActive.load())
+		return false;
+	--liveThreads;
+	workerStates[threadId].store(GENO_THREAD_POOL_WORKER_EXITED);
+	// A job submitted while this worker was leaving may have seen it as live and not started anyone,
+	// a submitter that looks after this point sees the slot free and starts a worker in it
+	if (hasRunnableJob(true)) {
+		workerStates[threadId].store(GENO_THREAD_POOL_WORKER_RUNNING);
+		++liveThreads;
+		return false;
+	}
+	return true;
+}
+
+void GenoThreadPool::wakeWorkers(uint32 num) {
+	if (numThreads == 0) {
+		// Threads waiting on the pool are the only ones that run its jobs
+		std::lock_guard<std::mutex> lock(parkMutex);
+		waitCondition.notify_all();
+		return;
+	}
+	if (sleepingThreads.load() == 0)
+		return;
+	std::lock_guard<std::mutex> lock(parkMutex);
+	if (num >= sleepingThreads.load())
+		jobCondition.notify_all();
+	else
+		for (uint32 i = 0; i < num; ++i)
+			jobCondition.notify_one();
+}
+
+void GenoThreadPool::submitJobs(uint32 num, GenoThreadPoolJob job, const GenoThreadPoolJobData data[], uint32 priority) {
+	submitRawJobs(0, num, job, data, priority);
+}
+
+void GenoThreadPool::submitJobs(GenoJobCounter & counter, uint32 num, GenoThreadPoolJob job, const GenoThreadPoolJobData data[], uint32 priority) {
+	submitRawJobs(&counter, num, job, data, priority);
+}
+
+void GenoThreadPool::submitJobAfter(GenoJobCounter & counter, GenoThreadPoolJob job, GenoThreadPoolJobData data, uint32 priority) {
+	counter.continuationJob      = job;
+	counter.continuationData     = data;
+	counter.continuationPriority = priority;
+	if (counter.count.fetch_or(GENO_JOB_COUNTER_CONTINUATION, std::memory_order_acq_rel) == 0) {
+		counter.count.store(0, std::memory_order_release);
+		submitJob(job, data, priority);
 	}
-	jobs[jobCount] = { job, data };
-	++jobCount;
 }
 
 void GenoThreadPool::wait() {
-	while (jobCount > 0)
-		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(1));
-	for (uint32 i = 0; i < numThreads; ++i) {
-		if (activeThreads[i].load()) {
-			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(1));
-			i = 0;
+	bool worker = currentPool == this;
+	while (pendingJobs.load() != 0) {
+		if (runQueuedJob())
+			continue;
+		if (hasRunnableJob(worker))
+			std::this_thread::yield();
+		else {
+			// Without workers a job submitted from another thread has to wake the waiter to be run at all
+			std::unique_lock<std::mutex> lock(parkMutex);
+			waitCondition.wait(lock, [this, worker] { return pendingJobs.load() == 0 || hasRunnableJob(worker); });
 		}
 	}
 }
 
+void GenoThreadPool::wait(const GenoJobCounter & counter) {
+	while (!counter.isDone()) {
+		if (runQueuedJob())
+			continue;
+		if (hasRunnableJob(currentPool == this))
+			std::this_thread::yield();
+		else {
+			// Nothing left to help with, the counter's remaining jobs are running elsewhere
+			std::unique_lock<std::mutex> lock(parkMutex);
+			++counterWaiters;
+			waitCondition.wait(lock, [this, &counter] { return counter.isDone() || hasRunnableJob(currentPool == this); });
+			--counterWaiters;
+		}
+	}
+}
+
+void GenoThreadPool::setCollectStats(bool collect) {
+	collectStats.store(collect, std::memory_order_relaxed);
+}
+
+void GenoThreadPool::getStats(uint32 thread, GenoThreadPoolStats & stats) const {
+	stats = {};
+	if (thread > numThreads)
+		return;
+	const GenoThreadPoolCounters & counter = counters[thread];
+	stats.jobsExecuted     = counter.jobsExecuted.load(std::memory_order_relaxed);
+	stats.busyTime         = counter.busyTime.load(std::memory_order_relaxed);
+	stats.idleTime         = counter.idleTime.load(std::memory_order_relaxed);
+	stats.stealAttempts    = counter.stealAttempts.load(std::memory_order_relaxed);
+	stats.steals           = counter.steals.load(std::memory_order_relaxed);
+	stats.queueHighWater   = counter.queueHighWater.load(std::memory_order_relaxed);
+	stats.lockWaitTime     = counter.lockWaitTime.load(std::memory_order_relaxed);
+	stats.scratchHighWater = counter.scratchHighWater.load(std::memory_order_relaxed);
+	for (uint32 i = 0; i < GENO_THREAD_POOL_LATENCY_BUCKETS; ++i)
+		stats.latencies[i] = counter.latencies[i].load(std::memory_order_relaxed);
+}
+
+void GenoThreadPool::resetStats() {
+	for (uint32 i = 0; i <= numThreads; ++i)
+		resetCounters(counters[i]);
+}
+
+bool GenoThreadPool::dumpStats(const char * path) const {
+	FILE * file = fopen(path, "a");
+	if (!file)
+		return false;
+	fprintf(file, "GenoThreadPool %p at %llu ns\n", (const void *) this, (unsigned long long) GenoTime::now());
+	for (uint32 i = 0; i <= numThreads; ++i) {
+		GenoThreadPoolStats stats;
+		getStats(i, stats);
+		if (i < numThreads)
+			fprintf(file, "\tworker %u:", i);
+		else
+			fprintf(file, "\toutside:");
+		fprintf(file, " jobs %llu busy %llu idle %llu steals %llu/%llu queue %llu lock %llu scratch %llu latency",
+		        (unsigned long long) stats.jobsExecuted, (unsigned long long) stats.busyTime, (unsigned long long) stats.idleTime,
+		        (unsigned long long) stats.steals, (unsigned long long) stats.stealAttempts, (unsigned long long) stats.queueHighWater,
+		        (unsigned long long) stats.lockWaitTime, (unsigned long long) stats.scratchHighWater);
+		for (uint32 j = 0; j < GENO_THREAD_POOL_LATENCY_BUCKETS; ++j)
+			fprintf(file, " %llu", (unsigned long long) stats.latencies[j]);
+		fprintf(file, "\n");
+	}
+	bool written = !ferror(file);
+	fclose(file);
+	return written;
+}
+
+void GenoThreadPool::setStatsDump(const char * path, uint32 interval) {
+	uint64 nanos = (uint64) interval * 1000000;
+	dumpInterval.store(nanos, std::memory_order_relaxed);
+	nextDump.store(GenoTime::now() + nanos, std::memory_order_relaxed);
+	dumpPath.store(path, std::memory_order_release);
+}
+
+uint32 GenoThreadPool::getThreadCount() const {
+	return numThreads;
+}
+
+uint32 GenoThreadPool::getLiveThreadCount() const {
+	return liveThreads.load();
+}
+
 GenoThreadPool::~GenoThreadPool() {
-	isActive.store(false);
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(parkMutex);
+		isActive.store(false);
+	}
+	jobCondition.notify_all();
+	// Waits out any worker being started, after which none can be since the pool is inactive. The lock
+	// is not held while joining as a retiring worker takes it
+	{
+		std::lock_guard<std::mutex> lock(scaleMutex);
+	}
+	for (uint32 i = 0; i < numThreads; ++i)
+		if (threads[i].joinable())
+			threads[i].join();
+	for (uint32 i = 0; i < numThreads * GENO_THREAD_POOL_PRIORITIES; ++i)
+		delete deques[i];
+	delete [] deques;
 	for (uint32 i = 0; i < numThreads; ++i)
-		threads[i].join();
+		delete scratchAllocators[i];
+	delete [] scratchAllocators;
 	delete [] threads;
-	delete [] activeThreads;
-	delete [] jobs;
+	delete [] workerStates;
+	delete [] counters;
+	delete [] workerCpus;
+	delete [] allowedCpus;
+	delete [] stealOrder;
+	delete [] localVictims;
 }
\ No newline at end of file
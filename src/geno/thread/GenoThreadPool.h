@@ -27,41 +27,295 @@
 #ifndef GNARLY_GENOME_THREAD_POOL
 #define GNARLY_GENOME_THREAD_POOL
 
+#include <new>
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+#include <condition_variable>
 
 #include "../GenoInts.h"
+#include "../template/GenoQueue.h"
+#include "../template/GenoArrayList.h"
+#include "../template/GenoWorkStealingDeque.h"
+#include "GenoScratchAllocator.h"
 
 typedef void * GenoThreadPoolJobData;
 typedef void (*GenoThreadPoolJob)(GenoThreadPoolJobData data);
 
 /**
- * A thread pool
+ * The number of bytes a job slot holds inline for a callable and its captures
+**/
+#define GENO_THREAD_POOL_JOB_STORAGE 48
+
+/**
+ * The number of buckets in a thread pool's queue to start latency histogram
+**/
+#define GENO_THREAD_POOL_LATENCY_BUCKETS 16
+
+/**
+ * Job priorities, workers always take the highest priority job they can find. Background jobs
+ * only run on a limited number of workers and are never picked up by threads helping out in a wait
+**/
+#define GENO_THREAD_POOL_PRIORITY_CRITICAL   0x00
+#define GENO_THREAD_POOL_PRIORITY_NORMAL     0x01
+#define GENO_THREAD_POOL_PRIORITY_BACKGROUND 0x02
+
+#define GENO_THREAD_POOL_PRIORITIES 3
+
+/**
+ * Set in a job counter's count while a job is waiting to be submitted when the counter reaches zero
+**/
+#define GENO_JOB_COUNTER_CONTINUATION 0x80000000
+
+/**
+ * The queue latency in microseconds past which an elastic pool starts another worker, when none is given
+**/
+#define GENO_THREAD_POOL_DEFAULT_SCALE_UP_LATENCY 500
+
+/**
+ * Worker slot states of an elastic pool
+**/
+#define GENO_THREAD_POOL_WORKER_STOPPED 0x00
+#define GENO_THREAD_POOL_WORKER_RUNNING 0x01
+#define GENO_THREAD_POOL_WORKER_EXITED  0x02
+
+/**
+ * With no grain given, reductions and scans cut their range into this many blocks per thread (the caller counts)
+**/
+#define GENO_PARALLEL_REDUCE_BLOCKS_PER_THREAD 4
+
+template <typename R>
+class GenoThreadPoolFuture;
+
+struct GenoThreadPoolCreateInfo {
+	/** The number of worker threads, the most an elastic pool grows to. 0 leaves all work to threads that wait on the pool **/
+	uint32 numThreads;
+	/** The number of workers an elastic pool starts with and never shrinks below **/
+	uint32 minThreads;
+	/** The time in milliseconds a worker above minThreads stays parked without work before exiting, 0 keeps every worker running **/
+	uint32 idleTimeout;
+	/** The queue latency in microseconds past which an elastic pool starts another worker, 0 uses GENO_THREAD_POOL_DEFAULT_SCALE_UP_LATENCY **/
+	uint32 scaleUpLatency;
+	/** The number of times an idle worker yields and checks for work again before parking **/
+	uint32 spinCount;
+	/** The initial capacity of each job queue. Queues will grow to fit but resizing is expensive **/
+	uint32 initialQueueCapacity;
+	/** Pins each worker to its own logical cpu, one per physical core before any SMT siblings are used **/
+	bool pinWorkers;
+	/** Keeps workers off the physical core of the creating thread and pins that thread to it when pinning, unpinned workers may run on any other core **/
+	bool reserveCallerCore;
+	/** Makes workers steal from workers in their own cache domain before crossing to another **/
+	bool localStealing;
+	/** The most workers that may run background jobs at once, 0 lets every worker run them. Background jobs run while a background job waits share its worker's slot **/
+	uint32 maxBackgroundThreads;
+	/** Starts the pool collecting timings, see GenoThreadPool::setCollectStats **/
+	bool collectStats;
+	/** The block size of each worker's scratch allocator, 0 uses GENO_SCRATCH_ALLOCATOR_BLOCK_SIZE **/
+	uint64 scratchBlockSize;
+};
+
+/**
+ * A snapshot of the counters of one thread in a thread pool, times are in nanoseconds
+ *
+ * Bucket 0 of the latency histogram counts jobs that started less than a microsecond after they were
+ * submitted, bucket i counts [2^(i-1), 2^i) microseconds and the last bucket counts everything longer.
+**/
+struct GenoThreadPoolStats {
+	uint64 jobsExecuted;
+	uint64 busyTime;
+	uint64 idleTime;
+	uint64 stealAttempts;
+	uint64 steals;
+	uint64 queueHighWater;
+	uint64 lockWaitTime;
+	uint64 scratchHighWater;
+	uint64 latencies[GENO_THREAD_POOL_LATENCY_BUCKETS];
+};
+
+/**
+ * Counts the unfinished jobs submitted with it
+ *
+ * Pass a counter to GenoThreadPool::submitJob for each job in a batch, then GenoThreadPool::wait(counter)
+ * waits for just that batch. A counter may be reused once it reaches zero and must outlive its jobs.
+**/
+class GenoJobCounter {
+	private:
+		std::atomic<uint32> count;
+		GenoThreadPoolJob continuationJob;
+		GenoThreadPoolJobData continuationData;
+		uint32 continuationPriority;
+	public:
+		GenoJobCounter();
+		GenoJobCounter(const GenoJobCounter & counter) = delete;
+
+		/**
+		 * Returns the number of jobs that have not finished yet
+		**/
+		uint32 getCount() const;
+
+		/**
+		 * Returns whether every job submitted with the counter has finished
+		**/
+		bool isDone() const;
+
+	friend class GenoThreadPool;
+	friend class GenoTaskGraph;
+	template <typename R>
+	friend class GenoThreadPoolFuture;
+	template <typename T>
+	friend class GenoCoroutineTask;
+};
+
+/**
+ * A work stealing thread pool
+ *
+ * Every worker owns a deque per priority. Jobs submitted from a worker go to the bottom of its own deque,
+ * jobs submitted from any other thread go to a shared queue per priority. For each priority from highest
+ * to lowest, idle workers take from their own deque first, then the shared queue, then steal from the
+ * top of a random other worker's deque.
 **/
 class GenoThreadPool {
 	private:
 		struct GenoThreadPoolJobPackage {
+			void (*invoke)(GenoThreadPoolJobPackage & package);
+			uint64 queuedTime;
+			alignas(8) unsigned char storage[GENO_THREAD_POOL_JOB_STORAGE];
+		};
+
+		struct alignas(64) GenoThreadPoolCounters {
+			std::atomic<uint64> jobsExecuted;
+			std::atomic<uint64> busyTime;
+			std::atomic<uint64> idleTime;
+			std::atomic<uint64> stealAttempts;
+			std::atomic<uint64> steals;
+			std::atomic<uint64> queueHighWater;
+			std::atomic<uint64> lockWaitTime;
+			std::atomic<uint64> scratchHighWater;
+			std::atomic_bool scratchReset;
+			std::atomic<uint64> latencies[GENO_THREAD_POOL_LATENCY_BUCKETS];
+			uint64 idleSince;
+		};
+
+		struct GenoThreadPoolRawJob {
 			GenoThreadPoolJob job;
 			GenoThreadPoolJobData data;
+			GenoThreadPool * pool;
+			GenoJobCounter * counter;
 		};
 
 		std::atomic_bool isActive;
 		uint32 numThreads;
-		std::mutex jobMutex;
 		std::thread * threads;
-		std::atomic_bool * activeThreads;
 
-		uint32 jobCount;
-		uint32 jobCapacity;
-		GenoThreadPoolJobPackage * jobs;
+		uint32 minThreads;
+		uint32 spinCount;
+		uint64 idleTimeout;
+		uint64 scaleUpLatency;
+		std::mutex scaleMutex;
+		std::atomic<uint32> liveThreads;
+		std::atomic<uint32> * workerStates;
+		std::atomic<uint64> lastJobStart;
+		std::atomic<uint64> lastScaleUp;
+
+		GenoWorkStealingDeque<GenoThreadPoolJobPackage> ** deques;
+		GenoScratchAllocator ** scratchAllocators;
+
+		std::mutex jobMutex;
+		GenoQueue<GenoThreadPoolJobPackage> jobs[GENO_THREAD_POOL_PRIORITIES];
+		std::atomic<uint32> sharedJobs[GENO_THREAD_POOL_PRIORITIES];
+		std::atomic<int64> priorityJobs[GENO_THREAD_POOL_PRIORITIES];
+		uint32 maxBackgroundThreads;
+		std::atomic<uint32> backgroundThreads;
+
+		std::mutex parkMutex;
+		std::condition_variable jobCondition;
+		std::condition_variable waitCondition;
+		std::atomic<uint32> sleepingThreads;
+		std::atomic<uint32> spinningThreads;
+		std::atomic<int64> queuedJobs;
+		std::atomic<uint32> pendingJobs;
+		std::atomic<uint32> counterWaiters;
+
+		std::atomic_bool collectStats;
+		GenoThreadPoolCounters * counters;
+		std::atomic<uint64> nextDump;
+		std::atomic<uint64> dumpInterval;
+		std::atomic<const char *> dumpPath;
+
+		bool pinWorkers;
+		uint32 * workerCpus;
+		uint32 numAllowedCpus;
+		uint32 * allowedCpus;
+		uint32 * stealOrder;
+		uint32 * localVictims;
+
+		typedef void (*GenoParallelForBody)(const void * func, uint64 begin, uint64 end);
+
+		struct GenoParallelForContext {
+			GenoThreadPool * pool;
+			GenoParallelForBody body;
+			const void * func;
+			uint64 grain;
+			uint32 priority;
+			GenoJobCounter pendingRanges;
+		};
+
+		template <typename C, typename F>
+		struct GenoParallelForEachData {
+			C elements;
+			const F * func;
+		};
 
 		static void threadLoop(uint32 threadId, GenoThreadPool * pool);
+		static void parallelForJob(GenoParallelForContext * context, uint64 begin, uint64 end);
+		static void invokeRawJob(GenoThreadPoolJobPackage & package);
+		static void invokeCountedRawJob(GenoThreadPoolJobPackage & package);
+
+		template <typename F>
+		static void invokeJob(GenoThreadPoolJobPackage & package) {
+			(*((F *) package.storage))();
+		}
+
+		template <typename F>
+		static void parallelForBody(const void * func, uint64 begin, uint64 end) {
+			const F & body = *((const F *) func);
+			for (uint64 i = begin; i < end; ++i)
+				body(i);
+		}
+
+		template <typename C, typename F>
+		static void parallelForEachBody(const void * func, uint64 begin, uint64 end) {
+			auto data = (const GenoParallelForEachData<C, F> *) func;
+			for (uint64 i = begin; i < end; ++i)
+				(*data->func)(data->elements[i]);
+		}
 
-		GenoThreadPoolJobPackage * requestJob(uint32 threadId);
+		static GenoThreadPoolCreateInfo createInfo(uint32 numThreads, uint32 initialQueueCapacity);
+
+		void placeWorkers(const GenoThreadPoolCreateInfo & info);
+		bool hasRunnableJob(bool worker) const;
+		bool requestJob(uint32 threadId, GenoThreadPoolJobPackage & job, uint32 & priority);
+		bool takeJob(uint32 threadId, uint32 priority, GenoThreadPoolJobPackage & job);
+		bool stealJob(uint32 threadId, const uint32 * victims, uint32 numVictims, uint32 priority, GenoThreadPoolJobPackage & job);
+		void runJob(GenoThreadPoolJobPackage & job, uint32 priority, uint32 threadId);
+		void lockJobs(std::unique_lock<std::mutex> & lock, uint32 threadId);
+		void resetCounters(GenoThreadPoolCounters & counters);
+		void finishJob();
+		void finishCounted(GenoJobCounter & counter);
+		void submitPackage(GenoThreadPoolJobPackage & package, uint32 priority);
+		void submitRawJobs(GenoJobCounter * counter, uint32 num, GenoThreadPoolJob job, const GenoThreadPoolJobData data[], uint32 priority);
+		void wakeWorkers(uint32 num);
+		void startWorker();
+		void scaleUp(uint64 latency);
+		bool retireWorker(uint32 threadId);
+		void parallelForRange(GenoParallelForBody body, const void * func, uint64 begin, uint64 end, uint64 grain);
+		uint64 reduceBlockLength(uint64 length, uint64 grain) const;
 	public:
 		/**
-		 * Returns the number of physical threads the system has if possible
+		 * Returns the number of physical cores the system has, SMT siblings are not counted
 		**/
 		static uint32 physicalThreadCount();
 
@@ -69,29 +323,498 @@ class GenoThreadPool {
 		 * Creates a thread pool
 		 *
 		 * @param numThreads - The number of threads in the pool, defaults to physicalThreadCount()
-		 * @param initialQueueCapacity - The initial capacity of the job queue. Queue will grow to fit but resizing is expensive
+		 * @param initialQueueCapacity - The initial capacity of each job queue. Queues will grow to fit but resizing is expensive
 		**/
 		GenoThreadPool(uint32 numThreads = physicalThreadCount(), uint32 initialQueueCapacity = 16);
 
+		/**
+		 * Creates a thread pool with control over where its workers run
+		**/
+		GenoThreadPool(const GenoThreadPoolCreateInfo & info);
+
 		/**
 		 * Submits a job to the thread pool
 		 *
 		 * @param job - The job to be queued
 		 * @param data - The data for the queued job
+		 * @param priority - The priority of the job, one of the GENO_THREAD_POOL_PRIORITY_* values
 		**/
-		void submitJob(GenoThreadPoolJob job, GenoThreadPoolJobData data = 0);
+		void submitJob(GenoThreadPoolJob job, GenoThreadPoolJobData data = 0, uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL);
 
 		/**
-		 * Waits until all submitted jobs have finished
+		 * Submits a callable to the thread pool
+		 *
+		 * The callable is copied into the job slot itself so nothing is allocated. It must be trivially
+		 * copyable and fit in GENO_THREAD_POOL_JOB_STORAGE bytes, so capture large state by pointer.
+		 *
+		 * @param func - The callable to be queued, called with no arguments
+		 * @param priority - The priority of the job, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		template <typename F, typename = typename std::enable_if<!std::is_convertible<F, GenoThreadPoolJob>::value>::type>
+		void submitJob(const F & func, uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL) {
+			static_assert(std::is_trivially_copyable<F>::value, "GenoThreadPool jobs must be trivially copyable, capture by pointer instead!");
+			static_assert(sizeof(F) <= GENO_THREAD_POOL_JOB_STORAGE, "GenoThreadPool job captures exceed GENO_THREAD_POOL_JOB_STORAGE!");
+			static_assert(alignof(F) <= 8, "GenoThreadPool job captures must be at most 8 byte aligned!");
+			GenoThreadPoolJobPackage package;
+			package.invoke = invokeJob<F>;
+			memcpy(package.storage, &func, sizeof(F));
+			submitPackage(package, priority);
+		}
+
+		/**
+		 * Submits a job to the thread pool counted by counter
+		 *
+		 * @param counter - The counter to add the job to, it is decremented when the job finishes
+		 * @param job - The job to be queued
+		 * @param data - The data for the queued job
+		 * @param priority - The priority of the job, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		void submitJob(GenoJobCounter & counter, GenoThreadPoolJob job, GenoThreadPoolJobData data = 0, uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL);
+
+		/**
+		 * Submits a callable to the thread pool counted by counter
+		 *
+		 * The callable has 16 fewer bytes to work with than in the uncounted submitJob
+		 *
+		 * @param counter - The counter to add the job to, it is decremented when the job finishes
+		 * @param func - The callable to be queued, called with no arguments
+		 * @param priority - The priority of the job, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		template <typename F, typename = typename std::enable_if<!std::is_convertible<F, GenoThreadPoolJob>::value>::type>
+		void submitJob(GenoJobCounter & counter, const F & func, uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL) {
+			GenoThreadPool * pool = this;
+			GenoJobCounter * jobCounter = &counter;
+			counter.count.fetch_add(1, std::memory_order_relaxed);
+			submitJob([pool, jobCounter, func] {
+				func();
+				pool->finishCounted(*jobCounter);
+			}, priority);
+		}
+
+		/**
+		 * Submits a batch of jobs that share a function
+		 *
+		 * The whole batch is published with one lock and wakes as many sleeping workers as it can keep busy,
+		 * which is much cheaper than submitting the jobs one by one.
+		 *
+		 * @param num - The number of jobs
+		 * @param job - The job to be queued
+		 * @param data - The data for each queued job
+		 * @param priority - The priority of the jobs, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		void submitJobs(uint32 num, GenoThreadPoolJob job, const GenoThreadPoolJobData data[], uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL);
+
+		/**
+		 * Submits a batch of jobs that share a function counted by counter
+		 *
+		 * @param counter - The counter to add the jobs to, it is decremented as each job finishes
+		 * @param num - The number of jobs
+		 * @param job - The job to be queued
+		 * @param data - The data for each queued job
+		 * @param priority - The priority of the jobs, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		void submitJobs(GenoJobCounter & counter, uint32 num, GenoThreadPoolJob job, const GenoThreadPoolJobData data[], uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL);
+
+		/**
+		 * Submits a job once every job counted by counter has finished, without blocking
+		 *
+		 * The job is submitted right away if the counter is already done. A counter holds one pending
+		 * job at a time and no more jobs may be counted by it until that job has been submitted.
+		 *
+		 * @param counter - The counter to wait on
+		 * @param job - The job to be queued
+		 * @param data - The data for the queued job
+		 * @param priority - The priority of the job, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		void submitJobAfter(GenoJobCounter & counter, GenoThreadPoolJob job, GenoThreadPoolJobData data = 0, uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL);
+
+		/**
+		 * Submits a callable to the thread pool and returns a future holding its result
+		 *
+		 * The future cannot be copied or moved and waits for the job when destroyed, so keep it in
+		 * scope until the result is no longer needed. The callable has 8 fewer bytes to work with
+		 * than in submitJob since the job also carries the future's address.
+		 *
+		 * @param func - The callable to be queued, called with no arguments
+		 * @param priority - The priority of the job, one of the GENO_THREAD_POOL_PRIORITY_* values
+		**/
+		template <typename F>
+		GenoThreadPoolFuture<decltype(std::declval<const F &>()())> submitTask(const F & func, uint32 priority = GENO_THREAD_POOL_PRIORITY_NORMAL) {
+			return GenoThreadPoolFuture<decltype(std::declval<const F &>()())>(this, func, priority);
+		}
+
+		/**
+		 * Blocks until all submitted jobs have finished
+		 *
+		 * The calling thread runs queued jobs while it waits, which is what drains a pool without workers.
+		 * Must not be called from inside a job, the job itself counts as unfinished.
 		**/
 		void wait();
 
+		/**
+		 * Blocks until every job submitted with counter has finished
+		 *
+		 * The calling thread runs queued jobs while it waits and only sleeps once there are none left to take.
+		 * Other jobs in the pool keep running, so this is safe to call from inside a job. The jobs it helps
+		 * with may belong to anyone, so a job must never block on the thread waiting for it.
+		 *
+		 * @param counter - The counter to wait on
+		**/
+		void wait(const GenoJobCounter & counter);
+
+		/**
+		 * Runs one queued job on the calling thread
+		 *
+		 * @return - Whether there was a job to run
+		**/
+		bool runQueuedJob();
+
+		/**
+		 * Returns the scratch allocator of the calling thread
+		 *
+		 * Every job runs between a mark and a rewind of its thread's scratch allocator, so anything a job
+		 * allocates from it is released automatically when the job returns, along with anything allocated
+		 * by jobs it ran while waiting. Scratch memory must not be handed to other jobs or kept after the job
+		 * returns. Workers each have their own allocator, other threads get a thread local one.
+		**/
+		static GenoScratchAllocator & getScratch();
+
+		/**
+		 * Starts or stops collecting busy, idle and lock wait times and queue latencies
+		 *
+		 * Job, steal and queue depth counts are always collected. Timings cost two clock reads per job
+		 * so they are off unless requested.
+		**/
+		void setCollectStats(bool collect);
+
+		/**
+		 * Takes a snapshot of the counters of one thread
+		 *
+		 * @param thread - The worker to read, getThreadCount() reads the combined counters of all threads outside the pool
+		 * @param stats - Filled with the counters
+		**/
+		void getStats(uint32 thread, GenoThreadPoolStats & stats) const;
+
+		/**
+		 * Sets every counter back to zero
+		**/
+		void resetStats();
+
+		/**
+		 * Appends a text snapshot of every thread's counters to a file
+		 *
+		 * @return - Whether the file could be written
+		**/
+		bool dumpStats(const char * path) const;
+
+		/**
+		 * Makes the pool append a snapshot to a file periodically while stats are being collected
+		 *
+		 * The dump is written by whichever worker finishes a job after the interval has passed.
+		 *
+		 * @param path - The file to append to, it must stay valid while dumping is on, null stops dumping
+		 * @param interval - The time between dumps in milliseconds
+		**/
+		void setStatsDump(const char * path, uint32 interval);
+
+		/**
+		 * Calls func(i) for every i in [begin, end) across the pool and returns once all calls have finished
+		 *
+		 * The range is split recursively. A range is only split while it is larger than the grain and
+		 * nobody has taken the last half split off it yet, so cheap bodies run in long sequential stretches.
+		 * The calling thread runs part of the range and helps with other queued jobs instead of blocking.
+		 * Split ranges run at the priority of the job calling parallelFor, or normal priority outside the pool.
+		 *
+		 * @param begin - The first index
+		 * @param end - One past the last index
+		 * @param func - The loop body, called concurrently so it must be safe to call from several threads
+		 * @param grain - The smallest range worth splitting off, 0 picks one from the range and thread count
+		**/
+		template <typename F>
+		void parallelFor(uint64 begin, uint64 end, const F & func, uint64 grain = 0) {
+			if (end > begin)
+				parallelForRange(parallelForBody<F>, &func, begin, end, grain);
+		}
+
+		/**
+		 * Calls func(element) for every element in [begin, end) across the pool
+		 *
+		 * @see parallelFor
+		**/
+		template <typename T, typename F>
+		void parallelForEach(T * begin, T * end, const F & func, uint64 grain = 0) {
+			GenoParallelForEachData<T *, F> data = { begin, &func };
+			if (end > begin)
+				parallelForRange(parallelForEachBody<T *, F>, &data, 0, end - begin, grain);
+		}
+
+		/**
+		 * Calls func(element) for every element of list across the pool
+		 *
+		 * The list must not be resized until parallelForEach returns
+		 *
+		 * @see parallelFor
+		**/
+		template <typename T, typename S, typename F>
+		void parallelForEach(GenoArrayList<T, S> & list, const F & func, uint64 grain = 0) {
+			GenoParallelForEachData<GenoArrayList<T, S> &, F> data = { list, &func };
+			if (list.getLength() > 0)
+				parallelForRange(parallelForEachBody<GenoArrayList<T, S> &, F>, &data, 0, list.getLength(), grain);
+		}
+
+		template <typename T, typename S, typename F>
+		void parallelForEach(const GenoArrayList<T, S> & list, const F & func, uint64 grain = 0) {
+			GenoParallelForEachData<const GenoArrayList<T, S> &, F> data = { list, &func };
+			if (list.getLength() > 0)
+				parallelForRange(parallelForEachBody<const GenoArrayList<T, S> &, F>, &data, 0, list.getLength(), grain);
+		}
+
+		/**
+		 * Combines map(i) for every index in [begin, end) across the pool
+		 *
+		 * The range is cut into blocks that are each reduced into a partial on whichever thread runs them,
+		 * then the partials are combined in order on the calling thread. The operator only has to be
+		 * associative, not commutative. The partials live in the calling thread's scratch allocator, so
+		 * T does not have to be default constructible, only copy constructible and copy assignable.
+		 *
+		 * @param begin - The first index
+		 * @param end - One past the last index
+		 * @param identity - The value that leaves any other unchanged when combined with it
+		 * @param map - Returns the value for an index, called concurrently
+		 * @param reduce - Combines two values, called concurrently
+		 * @param grain - The length of each block, 0 picks one from the range and thread count
+		 *
+		 * @return - The combined value, identity for an empty range
+		**/
+		template <typename T, typename M, typename R>
+		T parallelReduce(uint64 begin, uint64 end, const T & identity, const M & map, const R & reduce, uint64 grain = 0) {
+			if (end <= begin)
+				return identity;
+			uint64 length = end - begin;
+			uint64 blockLength = reduceBlockLength(length, grain);
+			uint64 numBlocks = (length + blockLength - 1) / blockLength;
+			auto reduceBlock = [&](uint64 block) {
+				uint64 first = begin + block * blockLength;
+				uint64 last  = length - block * blockLength > blockLength ? first + blockLength : end;
+				T partial = identity;
+				for (uint64 i = first; i < last; ++i)
+					partial = reduce(partial, map(i));
+				return partial;
+			};
+			if (numBlocks == 1)
+				return reduceBlock(0);
+
+			GenoScratchAllocator & scratch = getScratch();
+			GenoScratchMark mark = scratch.getMark();
+			T * partials = (T *) scratch.allocate(sizeof(T) * numBlocks, alignof(T));
+			parallelFor(0, numBlocks, [&](uint64 block) { new (partials + block) T(reduceBlock(block)); }, 1);
+			T ret = partials[0];
+			for (uint64 i = 1; i < numBlocks; ++i)
+				ret = reduce(ret, partials[i]);
+			for (uint64 i = 0; i < numBlocks; ++i)
+				partials[i].~T();
+			scratch.rewind(mark);
+			return ret;
+		}
+
+		/**
+		 * Combines every element in [begin, end) across the pool
+		 *
+		 * @see parallelReduce
+		**/
+		template <typename T, typename R>
+		T parallelReduce(const T * begin, const T * end, const T & identity, const R & reduce, uint64 grain = 0) {
+			return parallelReduce((uint64) 0, (uint64) (end - begin), identity, [begin](uint64 i) -> const T & { return begin[i]; }, reduce, grain);
+		}
+
+		/**
+		 * Writes the running combination of input to output across the pool
+		 *
+		 * An inclusive scan writes op(input[0], ..., input[i]) to output[i], an exclusive scan writes the
+		 * combination of everything before i, starting from identity. Each block is reduced in parallel,
+		 * the block totals are scanned on the calling thread and then each block is scanned in parallel
+		 * starting from its total. Output may be the same array as input. The block totals live in the
+		 * calling thread's scratch allocator. T must be copy constructible and copy assignable.
+		 *
+		 * @param num - The number of elements
+		 * @param input - The elements to scan
+		 * @param output - Filled with the scan
+		 * @param identity - The value that leaves any other unchanged when combined with it
+		 * @param op - Combines two values, called concurrently
+		 * @param exclusive - Whether to leave each element out of its own output
+		 * @param grain - The length of each block, 0 picks one from the range and thread count
+		**/
+		template <typename T, typename R>
+		void parallelScan(uint64 num, const T input[], T output[], const T & identity, const R & op, bool exclusive = false, uint64 grain = 0) {
+			if (num == 0)
+				return;
+			uint64 blockLength = reduceBlockLength(num, grain);
+			uint64 numBlocks = (num + blockLength - 1) / blockLength;
+			auto scanBlock = [&](uint64 block, T running) {
+				uint64 first = block * blockLength;
+				uint64 last  = num - first > blockLength ? first + blockLength : num;
+				for (uint64 i = first; i < last; ++i) {
+					T value = input[i];
+					if (exclusive) {
+						output[i] = running;
+						running = op(running, value);
+					}
+					else
+						output[i] = running = op(running, value);
+				}
+			};
+			if (numBlocks == 1) {
+				scanBlock(0, identity);
+				return;
+			}
+
+			GenoScratchAllocator & scratch = getScratch();
+			GenoScratchMark mark = scratch.getMark();
+			T * offsets = (T *) scratch.allocate(sizeof(T) * numBlocks, alignof(T));
+			parallelFor(0, numBlocks, [&](uint64 block) {
+				uint64 first = block * blockLength;
+				uint64 last  = num - first > blockLength ? first + blockLength : num;
+				T partial = identity;
+				for (uint64 i = first; i < last; ++i)
+					partial = op(partial, input[i]);
+				new (offsets + block) T(partial);
+			}, 1);
+			T running = identity;
+			for (uint64 i = 0; i < numBlocks; ++i) {
+				T total = offsets[i];
+				offsets[i] = running;
+				running = op(running, total);
+			}
+			parallelFor(0, numBlocks, [&](uint64 block) { scanBlock(block, offsets[block]); }, 1);
+			for (uint64 i = 0; i < numBlocks; ++i)
+				offsets[i].~T();
+			scratch.rewind(mark);
+		}
+
+		/**
+		 * Returns the number of threads in the pool
+		 *
+		 * For an elastic pool this is the most workers it may run, see getLiveThreadCount
+		**/
+		uint32 getThreadCount() const;
+
+		/**
+		 * Returns the number of workers currently running
+		 *
+		 * An elastic pool starts minThreads workers. It adds one whenever queued jobs have waited longer
+		 * than scaleUpLatency with no worker free, and workers above minThreads exit after idleTimeout
+		 * milliseconds parked without work.
+		**/
+		uint32 getLiveThreadCount() const;
+
 		/**
 		 * Destroys the thread pool
 		 *
 		 * Waits until all jobs have been completed before exiting
 		**/
 		~GenoThreadPool();
+
+	friend class GenoTaskGraph;
+	template <typename R>
+	friend class GenoThreadPoolFuture;
+	template <typename T>
+	friend class GenoCoroutineTask;
+};
+
+/**
+ * The result of a job submitted with GenoThreadPool::submitTask
+ *
+ * Waiting on a future runs other queued jobs on the waiting thread until the result is ready, then
+ * sleeps once there are none left to take.
+**/
+template <typename R>
+class GenoThreadPoolFuture {
+	private:
+		GenoThreadPool * pool;
+		GenoJobCounter counter;
+		alignas(R) unsigned char result[sizeof(R)];
+
+		template <typename F>
+		GenoThreadPoolFuture(GenoThreadPool * pool, const F & func, uint32 priority) :
+			pool(pool) {
+			GenoThreadPoolFuture<R> * future = this;
+			counter.count.store(1, std::memory_order_relaxed);
+			pool->submitJob([future, func] {
+				new (future->result) R(func());
+				future->pool->finishCounted(future->counter);
+			}, priority);
+		}
+	public:
+		GenoThreadPoolFuture(const GenoThreadPoolFuture<R> & future) = delete;
+		GenoThreadPoolFuture<R> & operator=(const GenoThreadPoolFuture<R> & future) = delete;
+
+		/**
+		 * Returns whether the job has finished
+		**/
+		bool isReady() const {
+			return counter.isDone();
+		}
+
+		/**
+		 * Blocks until the job has finished, helping with queued jobs in the meantime
+		**/
+		void wait() {
+			pool->wait(counter);
+		}
+
+		/**
+		 * Waits for the job and returns its result
+		**/
+		R & get() {
+			wait();
+			return *((R *) result);
+		}
+
+		~GenoThreadPoolFuture() {
+			wait();
+			((R *) result)->~R();
+		}
+
+	friend class GenoThreadPool;
+};
+
+template <>
+class GenoThreadPoolFuture<void> {
+	private:
+		GenoThreadPool * pool;
+		GenoJobCounter counter;
+
+		template <typename F>
+		GenoThreadPoolFuture(GenoThreadPool * pool, const F & func, uint32 priority) :
+			pool(pool) {
+			GenoThreadPoolFuture<void> * future = this;
+			counter.count.store(1, std::memory_order_relaxed);
+			pool->submitJob([future, func] {
+				func();
+				future->pool->finishCounted(future->counter);
+			}, priority);
+		}
+	public:
+		GenoThreadPoolFuture(const GenoThreadPoolFuture<void> & future) = delete;
+		GenoThreadPoolFuture<void> & operator=(const GenoThreadPoolFuture<void> & future) = delete;
+
+		bool isReady() const {
+			return counter.isDone();
+		}
+
+		void wait() {
+			pool->wait(counter);
+		}
+
+		void get() {
+			wait();
+		}
+
+		~GenoThreadPoolFuture() {
+			wait();
+		}
+
+	friend class GenoThreadPool;
 };
 
 #define GNARLY_GENOME_THREAD_POOL_FORWARD
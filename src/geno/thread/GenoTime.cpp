@@ -26,12 +26,48 @@
 
 #include <thread>
 #include <chrono>
-#include <GLFW/glfw3.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 #include "GenoTime.h"
 
+#ifdef _WIN32
+namespace {
+	uint64 queryFrequency() {
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return frequency.QuadPart;
+	}
+}
+#endif // _WIN32
+
+uint64 GenoTime::now() {
+	#ifdef _WIN32
+		// Function local so it is ready even when called during another file's static initialization
+		static const uint64 frequency = queryFrequency();
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		// Split so the multiplication cannot overflow
+		uint64 ticks = counter.QuadPart;
+		return ticks / frequency * nanoseconds + ticks % frequency * nanoseconds / frequency;
+	#else
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return (uint64) time.tv_sec * nanoseconds + time.tv_nsec;
+	#endif // _WIN32
+}
+
 double GenoTime::getTime(GenoTimeScale scale) {
-	return glfwGetTime() * scale;
+	static const uint64 origin = now();
+	return (double) (now() - origin) / (nanoseconds / scale);
+}
+
+uint64 GenoTime::toNanos(double time, GenoTimeScale scale) {
+	return (uint64) (time * (nanoseconds / scale));
 }
 
 void GenoTime::sleep(double time, GenoTimeScale scale) {
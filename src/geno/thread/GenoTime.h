@@ -32,14 +32,32 @@
 enum GenoTimeScale : uint32 { seconds = 1, milliseconds = 1000, microseconds = 1000000, nanoseconds = 1000000000 };
 
 class GenoTime final {
+	private:
+		GenoTime();
+		~GenoTime();
 	public:
 
 		/**
-		 * Returns the time since the initialization of the engine
+		 * Returns a monotonic timestamp in nanoseconds
+		 *
+		 * The origin is arbitrary, only differences between timestamps mean anything. Does not need the
+		 * engine to be initialized and is cheap enough to call per job.
+		**/
+		static uint64 now();
+
+		/**
+		 * Returns the time since getTime was first called
 		 *
 		 * @param scale - The time scale in which to return the time
 		**/
 		static double getTime(GenoTimeScale scale = milliseconds);
+
+		/**
+		 * Converts a time to nanoseconds
+		 *
+		 * @param scale - The time scale of the time provided
+		**/
+		static uint64 toNanos(double time, GenoTimeScale scale = milliseconds);
 	
 		/**
 		 * Sleeps the current thread for the specified amount of time
@@ -57,4 +75,4 @@ class GenoTime final {
 };
 
 #define GNARLY_GENOME_TIME_FORWARD
-#endif // YOUR_DEFINE_HERE
\ No newline at end of file
+#endif // GNARLY_GENOME_TIME
\ No newline at end of file
@@ -0,0 +1,243 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#include <cmath>
+
+#include "GenoTime.h"
+#include "GenoThreadPool.h"
+
+#include "GenoTimerWheel.h"
+
+namespace {
+	const uint32 NO_TIMER = 0xFFFFFFFF;
+	const uint64 SLOT_MASK = GENO_TIMER_WHEEL_SLOTS - 1;
+}
+
+GenoTimerWheelCreateInfo GenoTimerWheel::createInfo(double tickLength) {
+	GenoTimerWheelCreateInfo info = {};
+	info.tickLength      = tickLength;
+	info.initialCapacity = 64;
+	info.priority        = GENO_THREAD_POOL_PRIORITY_NORMAL;
+	return info;
+}
+
+void GenoTimerWheel::timerLoop(GenoTimerWheel * wheel) {
+	while (wheel->running.load()) {
+		wheel->advance();
+		// Sleeping to the next tick boundary rather than for a tick keeps time spent in callbacks from adding up as drift
+		double elapsed = GenoTime::getTime(milliseconds) - wheel->startTime;
+		GenoTime::sleepUntil(wheel->startTime + (std::floor(elapsed / wheel->tickLength) + 1) * wheel->tickLength);
+	}
+}
+
+GenoTimerWheel::GenoTimerWheel(double tickLength) :
+	GenoTimerWheel(createInfo(tickLength)) {}
+
+GenoTimerWheel::GenoTimerWheel(const GenoTimerWheelCreateInfo & info) :
+	tickLength(info.tickLength > 0 ? info.tickLength : 1),
+	startTime(GenoTime::getTime(milliseconds)),
+	currentTick(0),
+	pool(info.pool),
+	priority(info.priority),
+	freeNodes(NO_TIMER),
+	numTimers(0),
+	nodes(info.initialCapacity == 0 ? 16 : info.initialCapacity),
+	fired(16),
+	running(false) {
+	for (uint32 i = 0; i < GENO_TIMER_WHEEL_LEVELS * GENO_TIMER_WHEEL_SLOTS; ++i)
+		slots[i] = NO_TIMER;
+	for (uint32 i = 0; i < GENO_TIMER_WHEEL_LEVELS; ++i)
+		levelTimers[i] = 0;
+}
+
+void GenoTimerWheel::link(uint32 index) {
+	GenoTimerNode & node = nodes[index];
+	// The highest bits where the expiry differs from now pick the level, so a timer cascades once those bits match
+	uint64 differing = node.expiry ^ currentTick;
+	uint32 level = 0;
+	while (level < GENO_TIMER_WHEEL_LEVELS - 1 && (differing >> ((level + 1) * GENO_TIMER_WHEEL_SLOT_BITS)) != 0)
+		++level;
+	uint64 slot;
+	if ((differing >> (GENO_TIMER_WHEEL_LEVELS * GENO_TIMER_WHEEL_SLOT_BITS)) != 0)
+		// Past the top level, park in its first slot which cascades each time the top level wraps around
+		slot = 0;
+	else
+		slot = (node.expiry >> (level * GENO_TIMER_WHEEL_SLOT_BITS)) & SLOT_MASK;
+	node.slot = level * GENO_TIMER_WHEEL_SLOTS + (uint32) slot;
+	node.prev = NO_TIMER;
+	node.next = slots[node.slot];
+	if (node.next != NO_TIMER)
+		nodes[node.next].prev = index;
+	slots[node.slot] = index;
+	++levelTimers[level];
+}
+
+void GenoTimerWheel::unlink(uint32 index) {
+	GenoTimerNode & node = nodes[index];
+	if (node.prev == NO_TIMER)
+		slots[node.slot] = node.next;
+	else
+		nodes[node.prev].next = node.next;
+	if (node.next != NO_TIMER)
+		nodes[node.next].prev = node.prev;
+	--levelTimers[node.slot / GENO_TIMER_WHEEL_SLOTS];
+}
+
+void GenoTimerWheel::release(uint32 index) {
+	GenoTimerNode & node = nodes[index];
+	++node.generation;
+	node.next = freeNodes;
+	freeNodes = index;
+	--numTimers;
+}
+
+void GenoTimerWheel::cascade(uint32 level) {
+	uint32 & slot = slots[level * GENO_TIMER_WHEEL_SLOTS + ((currentTick >> (level * GENO_TIMER_WHEEL_SLOT_BITS)) & SLOT_MASK)];
+	uint32 index = slot;
+	slot = NO_TIMER;
+	while (index != NO_TIMER) {
+		uint32 next = nodes[index].next;
+		--levelTimers[level];
+		link(index);
+		index = next;
+	}
+}
+
+void GenoTimerWheel::tick() {
+	++currentTick;
+	for (uint32 level = GENO_TIMER_WHEEL_LEVELS - 1; level > 0; --level)
+		if ((currentTick & ((1ull << (level * GENO_TIMER_WHEEL_SLOT_BITS)) - 1)) == 0)
+			cascade(level);
+
+	uint32 & slot = slots[currentTick & SLOT_MASK];
+	uint32 index = slot;
+	slot = NO_TIMER;
+	while (index != NO_TIMER) {
+		GenoTimerNode & node = nodes[index];
+		uint32 next = node.next;
+		--levelTimers[0];
+		fired.add({ node.callback, node.data });
+		if (node.period != 0) {
+			node.expiry += node.period;
+			link(index);
+		}
+		else
+			release(index);
+		index = next;
+	}
+}
+
+GenoTimer GenoTimerWheel::schedule(double delay, GenoTimerCallback callback, GenoTimerData data, double period) {
+	double due = std::ceil((GenoTime::getTime(milliseconds) + delay - startTime) / tickLength);
+	std::lock_guard<std::mutex> lock(timerMutex);
+	uint32 index;
+	if (freeNodes != NO_TIMER) {
+		index = freeNodes;
+		freeNodes = nodes[index].next;
+	}
+	else {
+		index = nodes.getLength();
+		nodes.add({});
+	}
+	GenoTimerNode & node = nodes[index];
+	node.expiry   = due > currentTick ? (uint64) due : currentTick + 1;
+	node.period   = period > 0 ? (uint64) std::fmax(std::round(period / tickLength), 1) : 0;
+	node.callback = callback;
+	node.data     = data;
+	link(index);
+	++numTimers;
+	return { index, node.generation };
+}
+
+bool GenoTimerWheel::cancel(GenoTimer timer) {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	if (timer.index >= nodes.getLength() || nodes[timer.index].generation != timer.generation)
+		return false;
+	unlink(timer.index);
+	release(timer.index);
+	return true;
+}
+
+uint32 GenoTimerWheel::advance() {
+	return advanceTo(GenoTime::getTime(milliseconds));
+}
+
+uint32 GenoTimerWheel::advanceTo(double time) {
+	double target = std::floor((time - startTime) / tickLength);
+	{
+		std::lock_guard<std::mutex> lock(timerMutex);
+		while (currentTick < target) {
+			uint32 level = 0;
+			while (level < GENO_TIMER_WHEEL_LEVELS && levelTimers[level] == 0)
+				++level;
+			if (level == 0) {
+				tick();
+				continue;
+			}
+			if (level == GENO_TIMER_WHEEL_LEVELS) {
+				currentTick = (uint64) target;
+				break;
+			}
+			// With every level below empty nothing happens until the next cascade of the lowest occupied level
+			uint64 next = ((currentTick >> (level * GENO_TIMER_WHEEL_SLOT_BITS)) + 1) << (level * GENO_TIMER_WHEEL_SLOT_BITS);
+			if (next > target)
+				currentTick = (uint64) target;
+			else {
+				currentTick = next - 1;
+				tick();
+			}
+		}
+	}
+	// Callbacks run outside the lock so they can schedule and cancel timers
+	uint32 numFired = fired.getLength();
+	for (uint32 i = 0; i < numFired; ++i) {
+		if (pool)
+			pool->submitJob(fired[i].callback, fired[i].data, priority);
+		else
+			fired[i].callback(fired[i].data);
+	}
+	fired.clear();
+	return numFired;
+}
+
+void GenoTimerWheel::start() {
+	if (!running.exchange(true))
+		timerThread = std::thread(timerLoop, this);
+}
+
+void GenoTimerWheel::stop() {
+	if (running.exchange(false))
+		timerThread.join();
+}
+
+uint32 GenoTimerWheel::getTimerCount() {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	return numTimers;
+}
+
+GenoTimerWheel::~GenoTimerWheel() {
+	stop();
+}
\ No newline at end of file
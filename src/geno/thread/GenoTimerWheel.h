@@ -0,0 +1,186 @@
+/*******************************************************************************
+ *
+ * Copyright (c) 2019 Gnarly Narwhal
+ *
+ * -----------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *******************************************************************************/
+
+#ifndef GNARLY_GENOME_THREAD_POOL_FORWARD
+#define GNARLY_GENOME_THREAD_POOL_FORWARD
+
+class GenoThreadPool;
+
+#endif // GNARLY_GENOME_THREAD_POOL_FORWARD
+
+#ifndef GNARLY_GENOME_TIMER_WHEEL
+#define GNARLY_GENOME_TIMER_WHEEL
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+
+#include "../GenoInts.h"
+#include "../template/GenoArrayList.h"
+
+typedef void * GenoTimerData;
+typedef void (*GenoTimerCallback)(GenoTimerData data);
+
+/**
+ * The wheel has GENO_TIMER_WHEEL_LEVELS levels of 2^GENO_TIMER_WHEEL_SLOT_BITS slots each, every level
+ * covering 2^GENO_TIMER_WHEEL_SLOT_BITS times the span of the one below it
+**/
+#define GENO_TIMER_WHEEL_SLOT_BITS 8
+#define GENO_TIMER_WHEEL_SLOTS     (1 << GENO_TIMER_WHEEL_SLOT_BITS)
+#define GENO_TIMER_WHEEL_LEVELS    4
+
+/**
+ * A handle to a scheduled timer, handles of fired or cancelled timers are safely ignored
+**/
+struct GenoTimer {
+	uint32 index;
+	uint32 generation;
+};
+
+struct GenoTimerWheelCreateInfo {
+	/** The resolution of the wheel in milliseconds, 0 uses 1 millisecond **/
+	double tickLength;
+	/** The number of timers to make room for up front **/
+	uint32 initialCapacity;
+	/** Fired callbacks are submitted to this pool instead of run by the advancing thread when set **/
+	GenoThreadPool * pool;
+	/** The priority of callbacks submitted to the pool **/
+	uint32 priority;
+};
+
+/**
+ * A hierarchical timer wheel for one shot and periodic callbacks
+ *
+ * Scheduling and cancelling are constant time, timers live in intrusive lists hanging off the slot
+ * they expire in. Timers further out sit in coarser levels and cascade down as the wheel turns.
+ * The wheel is turned by calling advance from the loop or by starting its own timer thread. Any
+ * thread may schedule and cancel, but only one thread should advance the wheel.
+**/
+class GenoTimerWheel {
+	private:
+		struct GenoTimerNode {
+			uint64 expiry;
+			uint64 period;
+			GenoTimerCallback callback;
+			GenoTimerData data;
+			uint32 prev;
+			uint32 next;
+			uint32 generation;
+			uint32 slot;
+		};
+
+		struct GenoTimerFiring {
+			GenoTimerCallback callback;
+			GenoTimerData data;
+		};
+
+		std::mutex timerMutex;
+		double tickLength;
+		double startTime;
+		uint64 currentTick;
+		GenoThreadPool * pool;
+		uint32 priority;
+		uint32 freeNodes;
+		uint32 numTimers;
+		GenoArrayList<GenoTimerNode> nodes;
+		GenoArrayList<GenoTimerFiring> fired;
+		uint32 slots[GENO_TIMER_WHEEL_LEVELS * GENO_TIMER_WHEEL_SLOTS];
+		uint32 levelTimers[GENO_TIMER_WHEEL_LEVELS];
+
+		std::atomic_bool running;
+		std::thread timerThread;
+
+		static GenoTimerWheelCreateInfo createInfo(double tickLength);
+		static void timerLoop(GenoTimerWheel * wheel);
+
+		void link(uint32 index);
+		void unlink(uint32 index);
+		void release(uint32 index);
+		void cascade(uint32 level);
+		void tick();
+
+	public:
+		GenoTimerWheel(double tickLength = 1);
+		GenoTimerWheel(const GenoTimerWheelCreateInfo & info);
+
+		GenoTimerWheel(const GenoTimerWheel & wheel) = delete;
+		GenoTimerWheel & operator=(const GenoTimerWheel & wheel) = delete;
+
+		/**
+		 * Schedules a callback
+		 *
+		 * @param delay - The time until the callback fires in milliseconds, rounded up to whole ticks
+		 * @param callback - The callback
+		 * @param data - The data passed to the callback
+		 * @param period - The time between firings of a periodic timer in milliseconds, 0 fires once
+		 *
+		 * @return - A handle to cancel the timer with
+		**/
+		GenoTimer schedule(double delay, GenoTimerCallback callback, GenoTimerData data = 0, double period = 0);
+
+		/**
+		 * Cancels a timer, periodic timers may cancel themselves from their own callback
+		 *
+		 * @return - Whether the timer was still scheduled
+		**/
+		bool cancel(GenoTimer timer);
+
+		/**
+		 * Fires every timer due by the current GenoTime
+		 *
+		 * @return - The number of callbacks fired
+		**/
+		uint32 advance();
+
+		/**
+		 * Fires every timer due by a time
+		 *
+		 * @param time - The GenoTime to advance to in milliseconds
+		 *
+		 * @return - The number of callbacks fired
+		**/
+		uint32 advanceTo(double time);
+
+		/**
+		 * Starts a thread that advances the wheel once per tick
+		**/
+		void start();
+
+		/**
+		 * Stops the timer thread, if it was started
+		**/
+		void stop();
+
+		/**
+		 * Returns the number of scheduled timers
+		**/
+		uint32 getTimerCount();
+
+		~GenoTimerWheel();
+};
+
+#define GNARLY_GENOME_TIMER_WHEEL_FORWARD
+#endif // GNARLY_GENOME_TIMER_WHEEL
\ No newline at end of file
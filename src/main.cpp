@@ -24,12 +24,16 @@
  *
  *******************************************************************************/
 
+#include <mutex>
+#include <thread>
 #include <iostream>
 #include <chrono>
 
 #include "geno/GenoInts.h"
 #include "geno/GenoMacros.h"
 
+#include "geno/template/GenoQueue.h"
+#include "geno/template/GenoConcurrentQueue.h"
 #include "geno/math/linear/GenoMatrix4.h"
 #include "geno/thread/GenoTime.h"
 #include "geno/engine/GenoEngine.h"
@@ -76,10 +80,62 @@ int32 main(int32 argc, char ** argv) {
 /*
 	const uint32 NUM_ITERATIONS = 1000000;
 	
+	// Two producers hand NUM_ITERATIONS values each to two consumers
+	GenoQueue<uint32> lockedQueue(1024);
+	std::mutex queueMutex;
+
 	auto begin1 = std::chrono::high_resolution_clock::now();
+	{
+		auto produce = [&] {
+			for (uint32 i = 0; i < NUM_ITERATIONS; ++i) {
+				std::lock_guard<std::mutex> lock(queueMutex);
+				lockedQueue.enqueue(i);
+			}
+		};
+		auto consume = [&] {
+			for (uint32 i = 0; i < NUM_ITERATIONS;) {
+				std::unique_lock<std::mutex> lock(queueMutex);
+				if (lockedQueue.getLength() > 0) {
+					lockedQueue.dequeue();
+					++i;
+				}
+				else {
+					lock.unlock();
+					std::this_thread::yield();
+				}
+			}
+		};
+		std::thread threads[] = { std::thread(produce), std::thread(produce), std::thread(consume), std::thread(consume) };
+		for (auto & thread : threads)
+			thread.join();
+	}
 	auto end1 = std::chrono::high_resolution_clock::now();
 
+	GenoConcurrentQueue<uint32> concurrentQueue(1024);
+
 	auto begin2 = std::chrono::high_resolution_clock::now();
+	{
+		auto produce = [&] {
+			for (uint32 i = 0; i < NUM_ITERATIONS;) {
+				if (concurrentQueue.tryEnqueue(i))
+					++i;
+				else
+					std::this_thread::yield();
+			}
+		};
+		auto consume = [&] {
+			uint32 element;
+			for (uint32 i = 0; i < NUM_ITERATIONS;) {
+				if (concurrentQueue.tryDequeue(element))
+					++i;
+				else
+					std::this_thread::yield();
+			}
+		};
+		std::thread threads[] = { std::thread(produce), std::thread(produce), std::thread(consume), std::thread(consume) };
+		for (auto & thread : threads)
+			thread.join();
+	}
 	auto end2 = std::chrono::high_resolution_clock::now();
 	
 	std::cout << std::chrono::duration_cast<std::chrono::microseconds>(end1 - begin1).count() << std::endl;
@@ -225,7 +281,7 @@ void render() {
 	texture->bind();
 	shader->enable();
 	shader->setMvp(camera->getVPMatrix());
-	shader->setTextureTransform(texture->getTransform(0));
+	shader->setTextureTransform(texture->getAffineTransform(0));
 	vao->render();
 	window->swap();
 }